@@ -0,0 +1,81 @@
+#include "alias_table.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+AliasTable::AliasTable(const std::vector<double>& weights)
+    : bins(weights.size()) {
+  double total = 0;
+  for (double w : weights) {
+    if (w < 0) {
+      throw std::invalid_argument("Alias table weights must not be negative");
+    }
+    total += w;
+  }
+  if (!(total > 0)) {
+    throw std::invalid_argument("Alias table needs a positive weight");
+  }
+
+  // Scale so that the average bin holds 1, then let each bin below 1 be
+  // topped up by one above it.
+  const int n = weights.size();
+  std::vector<double> scaled(n);
+  std::vector<int> small;
+  std::vector<int> large;
+  for (int i = 0; i < n; ++i) {
+    bins[i].pmf = weights[i] / total;
+    scaled[i] = bins[i].pmf * n;
+    (scaled[i] < 1 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    const int s = small.back();
+    small.pop_back();
+    const int l = large.back();
+    bins[s].threshold = scaled[s];
+    bins[s].alias = l;
+    scaled[l] -= 1 - scaled[s];
+    if (scaled[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // What is left is 1 up to rounding.
+  for (int i : small) {
+    bins[i].threshold = 1;
+    bins[i].alias = i;
+  }
+  for (int i : large) {
+    bins[i].threshold = 1;
+    bins[i].alias = i;
+  }
+}
+
+int AliasTable::size() const {
+  return bins.size();
+}
+
+int AliasTable::sample(double u) const {
+  double remapped;
+  return sample(u, remapped);
+}
+
+int AliasTable::sample(double u, double& remapped) const {
+  const double scaled = u * bins.size();
+  const int i = std::min(static_cast<int>(scaled), size() - 1);
+  const double fraction = scaled - i;
+  const Bin& bin = bins[i];
+  // The fraction is uniform below the threshold when the bin keeps its index
+  // and above it when it picks the alias. Stretching that part back over
+  // [0, 1) gives the remapped value.
+  if (fraction < bin.threshold) {
+    remapped = fraction / bin.threshold;
+    return i;
+  }
+  remapped = std::min((fraction - bin.threshold) / (1 - bin.threshold),
+                      std::nextafter(1.0, 0.0));
+  return bin.alias;
+}
+
+double AliasTable::pmf(int i) const {
+  return bins[i].pmf;
+}
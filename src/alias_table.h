@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+// Samples an index with probability proportional to its weight in constant
+// time, by Vose's alias method.
+class AliasTable {
+ public:
+  // Throws std::invalid_argument unless the weights are non-negative with a
+  // positive sum.
+  AliasTable(const std::vector<double>& weights);
+
+  int size() const;
+  // Maps u in [0, 1) to an index.
+  int sample(double u) const;
+  // As above, and sets remapped to what is left of u once the index is
+  // picked, itself uniform in [0, 1), so that u can be used again.
+  int sample(double u, double& remapped) const;
+  // Probability of sampling index i.
+  double pmf(int i) const;
+
+ private:
+  struct Bin {
+    // Chance of keeping the bin's own index rather than its alias.
+    double threshold;
+    int alias;
+    double pmf;
+  };
+
+  std::vector<Bin> bins;
+};
@@ -0,0 +1,90 @@
+#include "band_writer.h"
+#include <algorithm>
+#include "color.h"
+
+BandWriter::BandWriter(std::ostream& o,
+                       int width,
+                       int height,
+                       int bh,
+                       int w,
+                       int spp)
+    : out{o},
+      image_width{width},
+      image_height{height},
+      band_height{bh},
+      window{w},
+      samples_per_pixel{spp},
+      slots(w, std::vector<Color>(width * bh)),
+      slot_ready(w, false),
+      written_bands{0} {
+  encoder = std::thread(&BandWriter::encode, this);
+}
+
+BandWriter::~BandWriter() {
+  finish();
+}
+
+int BandWriter::band_count() const {
+  return (image_height + band_height - 1) / band_height;
+}
+
+int BandWriter::first_row(int band) const {
+  return image_height - 1 - band * band_height;
+}
+
+int BandWriter::last_row(int band) const {
+  return std::max(first_row(band) - band_height + 1, 0);
+}
+
+Color* BandWriter::acquire_band(int band) {
+  std::unique_lock<std::mutex> lock(mutex);
+  slot_freed.wait(lock, [&] { return band < written_bands + window; });
+  return slots[band % window].data();
+}
+
+void BandWriter::complete_band(int band) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    slot_ready[band % window] = true;
+  }
+  band_completed.notify_one();
+}
+
+void BandWriter::finish() {
+  if (encoder.joinable()) {
+    encoder.join();
+  }
+}
+
+void BandWriter::encode() {
+  out << "P3" << std::endl;
+  out << image_width << " " << image_height << std::endl;
+  out << 255 << std::endl;
+
+  for (int band = 0; band < band_count(); ++band) {
+    const int slot = band % window;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      band_completed.wait(lock, [&] { return slot_ready[slot]; });
+    }
+
+    // The slot is not reused until written_bands moves past it, so it can be
+    // read without the lock.
+    const Color* pixels = slots[slot].data();
+    for (int row = first_row(band); row >= last_row(band); --row) {
+      const Color* line = pixels + (first_row(band) - row) * image_width;
+      for (int col = 0; col < image_width; ++col) {
+        write_color(out, line[col], samples_per_pixel);
+      }
+      out << '\n';
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slot_ready[slot] = false;
+      ++written_bands;
+    }
+    slot_freed.notify_all();
+  }
+  out.flush();
+}
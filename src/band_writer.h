@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "vec3.h"
+
+// Streams an image to a PPM file in horizontal bands, from the top of the
+// image down. Render threads fill bands and hand them over; a separate encoder
+// thread writes them in order while later bands are still rendering. Only
+// `window` bands are held in memory, so peak memory does not depend on the
+// image height.
+class BandWriter {
+ public:
+  BandWriter(std::ostream& out,
+             int image_width,
+             int image_height,
+             int band_height,
+             int window,
+             int samples_per_pixel);
+  ~BandWriter();
+
+  int band_count() const;
+  // Image rows covered by a band are [first_row, last_row], top row first.
+  int first_row(int band) const;
+  int last_row(int band) const;
+
+  // Blocks until the band fits in the window, then returns its buffer. The
+  // buffer holds band_height rows of image_width colors; row 0 is first_row.
+  Color* acquire_band(int band);
+  // Hands a filled band to the encoder.
+  void complete_band(int band);
+  // Blocks until every band has been written.
+  void finish();
+
+ private:
+  void encode();
+
+  std::ostream& out;
+  int image_width;
+  int image_height;
+  int band_height;
+  int window;
+  int samples_per_pixel;
+
+  std::vector<std::vector<Color>> slots;
+  std::vector<bool> slot_ready;
+  // Bands below this index have been written.
+  int written_bands;
+
+  std::mutex mutex;
+  std::condition_variable slot_freed;
+  std::condition_variable band_completed;
+  std::thread encoder;
+};
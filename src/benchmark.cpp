@@ -0,0 +1,255 @@
+#include "benchmark.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include "helpers.h"
+#include "image_io.h"
+#include "scenes.h"
+
+namespace {
+
+// Part of the name of cached references. Bump it whenever a change to the
+// renderer or the scenes changes the images, so old references are not
+// reused.
+const int reference_version = 1;
+
+struct BudgetResult {
+  double budget;
+  double seconds;
+  int samples;
+  ErrorMetrics error;
+};
+
+const char* sampler_name(SamplerType type) {
+  switch (type) {
+    case SamplerType::random:
+      return "random";
+    case SamplerType::stratified:
+      return "stratified";
+    case SamplerType::sobol:
+      return "sobol";
+    case SamplerType::blue_noise:
+      return "blue_noise";
+  }
+  return "unknown";
+}
+
+// JSON has no infinity or NaN, such as the PSNR of an exact match, so they
+// are written as null.
+void write_json_number(std::ostream& out, double value) {
+  if (std::isfinite(value)) {
+    out << value;
+  } else {
+    out << "null";
+  }
+}
+
+std::vector<Color> mean_image(const Color* sums, size_t size, int samples) {
+  std::vector<Color> image(size);
+  for (size_t i = 0; i < size; ++i) {
+    image[i] = sums[i] / samples;
+  }
+  return image;
+}
+
+// Loads the cached reference for a scene, or renders and caches it.
+std::vector<Color> reference_image(ThreadPool& pool,
+                                   const std::string& scene,
+                                   const RenderSettings& candidate,
+                                   const BenchmarkSettings& benchmark) {
+  // The reference uses the default depth and sampler so that candidates that
+  // change either are measured against the same ground truth. Its own seed
+  // keeps its noise independent of the candidate's. The lighting is part of
+  // the scene, so the environment map is the candidate's.
+  RenderSettings settings;
+  settings.seed = 0x5eed;
+  settings.image_width = candidate.image_width;
+  settings.image_height = candidate.image_height;
+  settings.samples_per_pixel = benchmark.reference_spp;
+  settings.environment = candidate.environment;
+
+  std::string environment_tag;
+  if (settings.environment) {
+    std::ostringstream hex;
+    hex << "_env" << std::hex << settings.environment->hash();
+    environment_tag = hex.str();
+  }
+
+  const std::string path =
+      benchmark.cache_dir + "/" + scene + "_" +
+      std::to_string(settings.image_width) + "x" +
+      std::to_string(settings.image_height) + "_" +
+      std::to_string(settings.samples_per_pixel) + "spp_d" +
+      std::to_string(settings.max_depth) + environment_tag + "_v" +
+      std::to_string(reference_version) + ".pfm";
+
+  int width, height;
+  std::vector<Color> pixels;
+  if (read_pfm(path, width, height, pixels) &&
+      width == settings.image_width && height == settings.image_height) {
+    std::cerr << "Using cached reference " << path << std::endl;
+    return pixels;
+  }
+
+  std::cerr << "Rendering reference " << path << std::endl;
+  const double aspect_ratio =
+      static_cast<double>(settings.image_width) / settings.image_height;
+  Renderer renderer(settings, make_scene(scene),
+                    make_scene_camera(scene, aspect_ratio));
+  renderer.render(pool);
+  pixels = mean_image(renderer.get_framebuffer(),
+                      settings.image_width * settings.image_height,
+                      settings.samples_per_pixel);
+  write_pfm(path, settings.image_width, settings.image_height, pixels);
+  return pixels;
+}
+
+// Renders one sample per pixel per pass until the last budget runs out or
+// the candidate's sample count is reached, measuring the error at each
+// budget on the way.
+std::vector<BudgetResult> run_candidate(ThreadPool& pool,
+                                        const std::string& scene,
+                                        const RenderSettings& candidate,
+                                        const BenchmarkSettings& benchmark,
+                                        const std::vector<Color>& reference) {
+  RenderSettings settings = candidate;
+  settings.report_progress = false;
+  const double aspect_ratio =
+      static_cast<double>(settings.image_width) / settings.image_height;
+  Renderer renderer(settings, make_scene(scene),
+                    make_scene_camera(scene, aspect_ratio));
+
+  std::vector<BudgetResult> results;
+  int samples = 0;
+  while (results.size() < benchmark.budgets.size()) {
+    renderer.render_pass(pool, samples, 1);
+    ++samples;
+
+    const double seconds = renderer.get_stats().seconds;
+    const bool out_of_samples = samples >= settings.samples_per_pixel;
+    while (results.size() < benchmark.budgets.size() &&
+           (seconds >= benchmark.budgets[results.size()] || out_of_samples)) {
+      const ErrorMetrics error = compare_images(
+          mean_image(renderer.get_framebuffer(), reference.size(), samples),
+          reference);
+      results.push_back(BudgetResult{benchmark.budgets[results.size()],
+                                     seconds, samples, error});
+    }
+  }
+  return results;
+}
+
+}  // namespace
+
+BenchmarkSettings::BenchmarkSettings()
+    : scenes{"scene_1", "random_scene"},
+      budgets{1, 2, 4, 8, 16},
+      reference_spp{4096},
+      cache_dir{"."},
+      curve_path{"benchmark_curve.csv"} {}
+
+void BenchmarkSettings::validate() const {
+  if (reference_spp < 1) {
+    throw std::invalid_argument("The reference needs at least one sample");
+  }
+  if (budgets.empty()) {
+    throw std::invalid_argument("Need at least one time budget");
+  }
+  for (size_t i = 0; i < budgets.size(); ++i) {
+    // Results are matched to budgets in order as time runs out.
+    if (!(budgets[i] > 0) || (i > 0 && !(budgets[i] > budgets[i - 1]))) {
+      throw std::invalid_argument(
+          "Time budgets must be positive and ascending");
+    }
+  }
+}
+
+ErrorMetrics compare_images(const std::vector<Color>& image,
+                            const std::vector<Color>& reference) {
+  if (image.size() != reference.size() || image.empty()) {
+    throw std::invalid_argument("compare_images needs images of equal size");
+  }
+
+  double squared_error = 0;
+  double relative_error = 0;
+  double display_error = 0;
+  for (size_t i = 0; i < image.size(); ++i) {
+    for (int c = 0; c < 3; ++c) {
+      const double value = image[i][c];
+      const double expected = reference[i][c];
+      const double diff = value - expected;
+      squared_error += diff * diff;
+      // The small constant keeps black reference pixels from dominating.
+      relative_error += diff * diff / (expected * expected + 0.01);
+
+      const double shown = clamp(sqrt(fmax(value, 0.0)), 0.0, 1.0);
+      const double shown_expected = clamp(sqrt(fmax(expected, 0.0)), 0.0, 1.0);
+      display_error += (shown - shown_expected) * (shown - shown_expected);
+    }
+  }
+
+  const double count = 3.0 * image.size();
+  const double display_mse = display_error / count;
+  return ErrorMetrics{sqrt(squared_error / count), relative_error / count,
+                      display_mse > 0 ? -10 * log10(display_mse) : infinity};
+}
+
+void run_benchmark(ThreadPool& pool,
+                   const RenderSettings& candidate,
+                   const BenchmarkSettings& benchmark,
+                   std::ostream& out) {
+  benchmark.validate();
+  std::ofstream curve(benchmark.curve_path);
+  if (!curve) {
+    throw std::runtime_error("Cannot open " + benchmark.curve_path);
+  }
+  curve << "scene,budget,seconds,spp,rmse,rel_mse,psnr" << std::endl;
+
+  out << "{\n";
+  out << "  \"candidate\": {\"width\": " << candidate.image_width
+      << ", \"height\": " << candidate.image_height
+      << ", \"max_spp\": " << candidate.samples_per_pixel
+      << ", \"max_depth\": " << candidate.max_depth << ", \"sampler\": \""
+      << sampler_name(candidate.sampler_type) << "\"},\n";
+  out << "  \"reference_spp\": " << benchmark.reference_spp << ",\n";
+  out << "  \"scenes\": [\n";
+
+  double log_rel_mse_sum = 0;
+  int points = 0;
+  for (size_t s = 0; s < benchmark.scenes.size(); ++s) {
+    const std::string& scene = benchmark.scenes[s];
+    const std::vector<Color> reference =
+        reference_image(pool, scene, candidate, benchmark);
+    std::cerr << "Benchmarking " << scene << std::endl;
+    const std::vector<BudgetResult> results =
+        run_candidate(pool, scene, candidate, benchmark, reference);
+
+    out << "    {\"scene\": \"" << scene << "\", \"points\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BudgetResult& r = results[i];
+      out << "      {\"budget\": " << r.budget << ", \"seconds\": "
+          << r.seconds << ", \"spp\": " << r.samples
+          << ", \"rmse\": ";
+      write_json_number(out, r.error.rmse);
+      out << ", \"rel_mse\": ";
+      write_json_number(out, r.error.rel_mse);
+      out << ", \"psnr\": ";
+      write_json_number(out, r.error.psnr);
+      out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+      curve << scene << "," << r.budget << "," << r.seconds << ","
+            << r.samples << "," << r.error.rmse << "," << r.error.rel_mse
+            << "," << r.error.psnr << std::endl;
+      log_rel_mse_sum += log(r.error.rel_mse);
+      ++points;
+    }
+    out << "    ]}" << (s + 1 < benchmark.scenes.size() ? "," : "") << "\n";
+  }
+
+  out << "  ],\n";
+  out << "  \"score\": ";
+  write_json_number(out, points ? exp(log_rel_mse_sum / points) : 0.0);
+  out << "\n";
+  out << "}" << std::endl;
+}
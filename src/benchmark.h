@@ -0,0 +1,51 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "renderer.h"
+#include "thread_pool.h"
+
+struct BenchmarkSettings {
+  BenchmarkSettings();
+
+  // Throws std::invalid_argument unless there is a reference sample and the
+  // budgets are positive and ascending.
+  void validate() const;
+
+  std::vector<std::string> scenes;
+  // Time budgets in seconds, ascending.
+  std::vector<double> budgets;
+  int reference_spp;
+  // Reference images are cached here, one PFM per scene, resolution,
+  // environment map and reference version.
+  std::string cache_dir;
+  // Error-vs-time curve as CSV.
+  std::string curve_path;
+};
+
+struct ErrorMetrics {
+  double rmse;
+  // Mean of squared error over squared reference, which weighs dark and
+  // bright regions alike.
+  double rel_mse;
+  // Peak signal to noise ratio in dB of the gamma corrected, clamped image,
+  // as it would be written out. Infinite for an exact match, which the JSON
+  // report writes as null.
+  double psnr;
+};
+
+// Compares two images of mean pixel values.
+ErrorMetrics compare_images(const std::vector<Color>& image,
+                            const std::vector<Color>& reference);
+
+// Equal-time convergence benchmark. Renders each scene progressively with
+// the candidate settings and measures the error against a high sample count
+// reference each time a budget runs out. Writes a JSON report to out. Its
+// score is the geometric mean of rel_mse over every scene and budget, so a
+// lower score means the candidate converges faster. Throws
+// std::invalid_argument for invalid benchmark settings.
+void run_benchmark(ThreadPool& pool,
+                   const RenderSettings& candidate,
+                   const BenchmarkSettings& benchmark,
+                   std::ostream& out);
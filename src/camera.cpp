@@ -1,4 +1,6 @@
 #include "camera.h"
+#include <algorithm>
+#include <cmath>
 #include "helpers.h"
 
 Camera::Camera(Point3 lookfrom,
@@ -26,11 +28,70 @@ Camera::Camera(Point3 lookfrom,
   lower_left_corner = origin - horizontal / 2 - vertical / 2 - focus_dist * w;
 
   lens_radius = aperture / 2;
+  this->focus_dist = focus_dist;
 }
 
-Ray Camera::get_ray(double s, double t) const {
-  Vec3 rd = lens_radius * random_in_unit_disk();
+Ray Camera::get_ray(double s, double t, Sampler& sampler) const {
+  const Point2 lens = sampler.get_2d();
+  Vec3 rd = lens_radius * sample_in_unit_disk(lens.u, lens.v);
   Vec3 offset = u * rd.get_x() + v * rd.get_y();
   return Ray(origin + offset, lower_left_corner + s * horizontal +
                                   t * vertical - origin - offset);
 }
+
+double Camera::pixel_spread(int image_height) const {
+  return vertical.length() / focus_dist / image_height;
+}
+
+bool Camera::screen_bounds(const Point3& box_min,
+                           const Point3& box_max,
+                           double& s_min,
+                           double& s_max,
+                           double& t_min,
+                           double& t_max) const {
+  s_min = t_min = infinity;
+  s_max = t_max = -infinity;
+
+  for (int i = 0; i < 8; ++i) {
+    const Point3 corner((i & 1) ? box_max.get_x() : box_min.get_x(),
+                        (i & 2) ? box_max.get_y() : box_min.get_y(),
+                        (i & 4) ? box_max.get_z() : box_min.get_z());
+    const Vec3 d = corner - origin;
+    const double depth = -dot(d, w);
+    if (depth <= 0) {
+      return false;
+    }
+
+    // Project onto the focus plane, then widen by the circle of confusion of
+    // a point at this depth.
+    const Point3 on_plane = origin + (focus_dist / depth) * d;
+    const double blur = lens_radius * fabs(1 - focus_dist / depth);
+    const Vec3 offset = on_plane - lower_left_corner;
+    const double s = dot(offset, horizontal) / horizontal.length_squared();
+    const double t = dot(offset, vertical) / vertical.length_squared();
+    const double s_blur = blur / horizontal.length();
+    const double t_blur = blur / vertical.length();
+
+    s_min = std::min(s_min, s - s_blur);
+    s_max = std::max(s_max, s + s_blur);
+    t_min = std::min(t_min, t - t_blur);
+    t_max = std::max(t_max, t + t_blur);
+  }
+  return true;
+}
+
+uint64_t Camera::hash() const {
+  const double values[] = {origin.get_x(),     origin.get_y(),
+                           origin.get_z(),     lower_left_corner.get_x(),
+                           lower_left_corner.get_y(), lower_left_corner.get_z(),
+                           horizontal.get_x(), horizontal.get_y(),
+                           horizontal.get_z(), vertical.get_x(),
+                           vertical.get_y(),   vertical.get_z(),
+                           lens_radius};
+  return hash_bytes(values, sizeof(values));
+}
+
+Camera CameraSetup::to_camera(double aspect_ratio) const {
+  return Camera(lookfrom, lookat, vup, vertical_fov_deg, aspect_ratio,
+                aperture, focus_dist);
+}
@@ -1,5 +1,7 @@
 #pragma once
+#include <cstdint>
 #include "ray.h"
+#include "samplers/sampler.h"
 #include "vec3.h"
 
 class Camera {
@@ -11,7 +13,24 @@ class Camera {
          double aspect_ratio,
          double aperture,
          double focus_dist);
-  Ray get_ray(double u, double v) const;
+  // Takes the lens position from the next 2D sample.
+  Ray get_ray(double u, double v, Sampler& sampler) const;
+
+  // Finds the range of get_ray() coordinates that can see the box spanned by
+  // box_min and box_max, including defocus blur. Returns false if part of the
+  // box is behind the camera.
+  bool screen_bounds(const Point3& box_min,
+                     const Point3& box_max,
+                     double& s_min,
+                     double& s_max,
+                     double& t_min,
+                     double& t_max) const;
+
+  // Angle between the rays through neighboring pixels of an image
+  // image_height pixels high.
+  double pixel_spread(int image_height) const;
+
+  uint64_t hash() const;
 
  private:
   Point3 origin;
@@ -20,4 +39,18 @@ class Camera {
   Vec3 vertical;
   Vec3 u, v, w;
   double lens_radius;
-};
\ No newline at end of file
+  double focus_dist;
+};
+
+// The parameters a Camera is built from, kept so that related views can be
+// derived from one placement.
+struct CameraSetup {
+  Point3 lookfrom;
+  Point3 lookat;
+  Vec3 vup;
+  double vertical_fov_deg;
+  double aperture;
+  double focus_dist;
+
+  Camera to_camera(double aspect_ratio) const;
+};
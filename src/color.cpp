@@ -11,5 +11,14 @@ std::ostream& write_color(std::ostream& out, Color color, int num_samples) {
 
   return out << static_cast<int>(256 * clamp(r, 0.0, 0.999)) << " "
              << static_cast<int>(256 * clamp(g, 0.0, 0.999)) << " "
-             << static_cast<int>(256 * clamp(b, 0.0, 0.999)) << std::endl;
-}
\ No newline at end of file
+             << static_cast<int>(256 * clamp(b, 0.0, 0.999)) << '\n';
+}
+
+Color lerp_color(Color color1, Color color2, double t) {
+  return (1.0 - t) * color1 + t * color2;
+}
+
+double luminance(const Color& color) {
+  return 0.2126 * color.get_x() + 0.7152 * color.get_y() +
+         0.0722 * color.get_z();
+}
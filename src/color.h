@@ -3,4 +3,7 @@
 #include <iostream>
 #include "vec3.h"
 
-std::ostream& write_color(std::ostream& out, Color color, int num_samples);
\ No newline at end of file
+std::ostream& write_color(std::ostream& out, Color color, int num_samples);
+Color lerp_color(Color color1, Color color2, double t);
+// Perceived brightness of a linear sRGB color.
+double luminance(const Color& color);
@@ -0,0 +1,99 @@
+#include "editable_scene.h"
+#include <stdexcept>
+#include "helpers.h"
+#include "hittables/instance.h"
+#include "hittables/wide_bvh.h"
+#include "materials/lambertian.h"
+#include "scenes.h"
+#include "transform.h"
+
+namespace {
+
+// Ancestors older than this are forgotten.
+const size_t max_ancestors = 8;
+
+enum EditKind : uint64_t { move_edit = 1, recolor_edit = 2 };
+
+uint64_t hash_edit(EditKind kind, int object_id, const Vec3& value) {
+  const double values[] = {static_cast<double>(kind),
+                           static_cast<double>(object_id), value.get_x(),
+                           value.get_y(), value.get_z()};
+  return hash_bytes(values, sizeof(values));
+}
+
+}  // namespace
+
+EditableScene::EditableScene(const std::string& n)
+    : name{n},
+      edit_chain_hash{hash_bytes(n.data(), n.size())},
+      objects{make_scene_objects(n)},
+      world{std::make_shared<WideBvh>(objects)} {}
+
+EditableScene::EditableScene(const EditableScene& parent,
+                             int object_id,
+                             std::shared_ptr<Hittable> replacement,
+                             uint64_t edit_hash)
+    : name{parent.name},
+      edit_chain_hash{hash_bytes(&edit_hash, sizeof(edit_hash),
+                                 parent.edit_chain_hash)} {
+  const auto& parent_objects = parent.objects.get_objects();
+  SceneChange change;
+  change.object_id = object_id;
+  parent_objects[object_id]->bounding_box(change.old_box);
+  replacement->bounding_box(change.new_box);
+  change.emitter = parent_objects[object_id]->emitted_power() > 0 ||
+                   replacement->emitted_power() > 0;
+
+  for (size_t i = 0; i < parent_objects.size(); ++i) {
+    objects.add(static_cast<int>(i) == object_id ? replacement
+                                                 : parent_objects[i]);
+  }
+  world = std::make_shared<WideBvh>(objects);
+
+  ancestors.push_back(SceneAncestor{parent.edit_chain_hash, {change}});
+  for (const SceneAncestor& older : parent.ancestors) {
+    if (ancestors.size() == max_ancestors) {
+      break;
+    }
+    SceneAncestor ancestor = older;
+    ancestor.changes.push_back(change);
+    ancestors.push_back(ancestor);
+  }
+}
+
+const std::string& EditableScene::get_name() const {
+  return name;
+}
+
+uint64_t EditableScene::get_edit_chain_hash() const {
+  return edit_chain_hash;
+}
+
+std::shared_ptr<const Hittable> EditableScene::get_world() const {
+  return world;
+}
+
+const std::vector<SceneAncestor>& EditableScene::get_ancestors() const {
+  return ancestors;
+}
+
+std::shared_ptr<const EditableScene> EditableScene::moved(
+    int object_id,
+    const Vec3& offset) const {
+  auto object = objects.get_objects().at(object_id);
+  auto replacement =
+      std::make_shared<Instance>(object, Transform::translate(offset));
+  return std::shared_ptr<const EditableScene>(new EditableScene(
+      *this, object_id, replacement, hash_edit(move_edit, object_id, offset)));
+}
+
+std::shared_ptr<const EditableScene> EditableScene::recolored(
+    int object_id,
+    const Color& albedo) const {
+  auto object = objects.get_objects().at(object_id);
+  auto replacement = std::make_shared<Instance>(
+      object, Transform(), std::make_shared<Lambertian>(albedo));
+  return std::shared_ptr<const EditableScene>(
+      new EditableScene(*this, object_id, replacement,
+                        hash_edit(recolor_edit, object_id, albedo)));
+}
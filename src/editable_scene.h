@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "hittables/aabb.h"
+#include "hittables/hittable.h"
+#include "hittables/hittable_list.h"
+
+// One edited top-level object and its world bounds before and after the edit.
+struct SceneChange {
+  int object_id;
+  Aabb old_box;
+  Aabb new_box;
+  // Whether the object emits light before or after the edit. Its light can
+  // reach any pixel, so the boxes do not bound what the edit changes.
+  bool emitter;
+};
+
+// Version of an earlier scene and the changes made since.
+struct SceneAncestor {
+  uint64_t edit_chain_hash;
+  std::vector<SceneChange> changes;
+};
+
+// Named scene whose top-level objects can be edited. Each version is
+// immutable and identified by its edit chain hash: a hash of the scene name
+// and of every edit applied to it, in order. It is not a hash of the scene's
+// content, so the same objects reached through different edits hash
+// differently. Renders of a version can be cached and reused under it.
+// Editing returns a new version that remembers its recent ancestors.
+class EditableScene {
+ public:
+  // Throws std::invalid_argument for unknown scene names.
+  EditableScene(const std::string& name);
+
+  const std::string& get_name() const;
+  uint64_t get_edit_chain_hash() const;
+  std::shared_ptr<const Hittable> get_world() const;
+  // Closest ancestor first.
+  const std::vector<SceneAncestor>& get_ancestors() const;
+
+  // Both throw std::out_of_range for unknown object ids.
+  std::shared_ptr<const EditableScene> moved(int object_id,
+                                             const Vec3& offset) const;
+  // Replaces the object's material with a Lambertian of the given albedo.
+  std::shared_ptr<const EditableScene> recolored(int object_id,
+                                                 const Color& albedo) const;
+
+ private:
+  EditableScene(const EditableScene& parent,
+                int object_id,
+                std::shared_ptr<Hittable> replacement,
+                uint64_t edit_hash);
+
+  std::string name;
+  uint64_t edit_chain_hash;
+  HittableList objects;
+  std::shared_ptr<const Hittable> world;
+  std::vector<SceneAncestor> ancestors;
+};
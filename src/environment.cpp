@@ -0,0 +1,87 @@
+#include "environment.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "color.h"
+#include "helpers.h"
+#include "image_io.h"
+
+namespace {
+
+std::vector<Color> load_pfm(const std::string& path, int& width, int& height) {
+  std::vector<Color> pixels;
+  if (!read_pfm(path, width, height, pixels)) {
+    throw std::runtime_error("Cannot read environment map " + path);
+  }
+  return pixels;
+}
+
+// Sampling weight of each pixel: its brightness times the solid angle it
+// covers, which shrinks towards the poles.
+std::vector<double> pixel_weights(const std::vector<Color>& pixels,
+                                  int width,
+                                  int height) {
+  std::vector<double> weights(pixels.size());
+  for (int row = 0; row < height; ++row) {
+    const double theta = (height - 1 - row + 0.5) / height * pi;
+    for (int col = 0; col < width; ++col) {
+      weights[row * width + col] =
+          std::max(luminance(pixels[row * width + col]), 0.0) * sin(theta);
+    }
+  }
+  return weights;
+}
+
+}  // namespace
+
+Environment::Environment(const std::string& path)
+    : width{0},
+      height{0},
+      pixels{load_pfm(path, width, height)},
+      table{pixel_weights(pixels, width, height)},
+      content_hash{hash_bytes(pixels.data(), pixels.size() * sizeof(Color))} {}
+
+Color Environment::radiance(const Vec3& direction) const {
+  double sin_theta;
+  return pixels[pixel_index(direction, sin_theta)];
+}
+
+Vec3 Environment::sample(double u, const Point2& jitter, double& pdf) const {
+  const int index = table.sample(u);
+  const int row_from_top = height - 1 - index / width;
+  const int col = index % width;
+
+  const double theta = (row_from_top + jitter.v) / height * pi;
+  const double phi = (col + jitter.u) / width * 2 * pi - pi;
+  const double sin_theta = sin(theta);
+  // Uniform within the pixel in (phi, theta), whose solid angle is
+  // sin(theta) times its area in those coordinates.
+  pdf = sin_theta > 0
+            ? table.pmf(index) * width * height / (2 * pi * pi * sin_theta)
+            : 0;
+  return Vec3(sin_theta * cos(phi), cos(theta), sin_theta * sin(phi));
+}
+
+double Environment::pdf(const Vec3& direction) const {
+  double sin_theta;
+  const int index = pixel_index(direction, sin_theta);
+  return sin_theta > 0
+             ? table.pmf(index) * width * height / (2 * pi * pi * sin_theta)
+             : 0;
+}
+
+uint64_t Environment::hash() const {
+  return content_hash;
+}
+
+int Environment::pixel_index(const Vec3& direction, double& sin_theta) const {
+  const Vec3 d = normalize(direction);
+  const double theta = acos(clamp(d.get_y(), -1, 1));
+  const double phi = atan2(d.get_z(), d.get_x());
+  sin_theta = sin(theta);
+  const int row_from_top =
+      std::min(static_cast<int>(theta / pi * height), height - 1);
+  const int col =
+      std::min(static_cast<int>((phi + pi) / (2 * pi) * width), width - 1);
+  return (height - 1 - row_from_top) * width + col;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "alias_table.h"
+#include "samplers/sampler.h"
+#include "vec3.h"
+
+// Light arriving from infinitely far away, from a latitude-longitude HDR
+// image. The top row of the image is straight up (+y) and the left edge
+// faces -x. Directions can be sampled in proportion to their brightness, so
+// small bright areas such as the sun are found without luck.
+class Environment {
+ public:
+  // Loads a PFM image. Throws std::runtime_error if it cannot be read.
+  Environment(const std::string& path);
+
+  Color radiance(const Vec3& direction) const;
+  // Picks a direction with a density proportional to the radiance, and sets
+  // pdf to that density over solid angle.
+  Vec3 sample(double u, const Point2& jitter, double& pdf) const;
+  // Density of sample() returning direction.
+  double pdf(const Vec3& direction) const;
+
+  // Hash of the image content.
+  uint64_t hash() const;
+
+ private:
+  // Pixel seen in direction, and the sine of its polar angle.
+  int pixel_index(const Vec3& direction, double& sin_theta) const;
+
+  int width;
+  int height;
+  // Row major with row 0 at the bottom, as stored in PFM files.
+  std::vector<Color> pixels;
+  AliasTable table;
+  uint64_t content_hash;
+};
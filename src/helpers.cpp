@@ -20,3 +20,20 @@ double random_double(double min, double max) {
 double clamp(double n, double min, double max) {
   return n >= max ? max : n <= min ? min : n;
 }
+
+// Linearly maps x from [in_min, in_max] to [out_min, out_max].
+double map(double x,
+           double in_min,
+           double in_max,
+           double out_min,
+           double out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    seed = (seed ^ bytes[i]) * 1099511628211ull;
+  }
+  return seed;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <memory>
@@ -14,3 +16,12 @@ double degrees_to_radians(double degrees);
 double random_double();
 double random_double(double min, double max);
 double clamp(double n, double min, double max);
+double map(double x,
+           double in_min,
+           double in_max,
+           double out_min,
+           double out_max);
+// FNV-1a hash of size bytes, continuing from seed.
+uint64_t hash_bytes(const void* data,
+                    size_t size,
+                    uint64_t seed = 14695981039346656037ull);
@@ -0,0 +1,28 @@
+#include "aabb.h"
+#include <cmath>
+
+Aabb::Aabb() {}
+
+Aabb::Aabb(const Point3& a, const Point3& b) : minimum{a}, maximum{b} {}
+
+Point3 Aabb::get_min() const {
+  return this->minimum;
+}
+
+Point3 Aabb::get_max() const {
+  return this->maximum;
+}
+
+Point3 Aabb::centroid() const {
+  return 0.5 * (this->minimum + this->maximum);
+}
+
+Aabb surrounding_box(const Aabb& box0, const Aabb& box1) {
+  Point3 small(fmin(box0.get_min().get_x(), box1.get_min().get_x()),
+               fmin(box0.get_min().get_y(), box1.get_min().get_y()),
+               fmin(box0.get_min().get_z(), box1.get_min().get_z()));
+  Point3 big(fmax(box0.get_max().get_x(), box1.get_max().get_x()),
+             fmax(box0.get_max().get_y(), box1.get_max().get_y()),
+             fmax(box0.get_max().get_z(), box1.get_max().get_z()));
+  return Aabb(small, big);
+}
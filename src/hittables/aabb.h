@@ -0,0 +1,20 @@
+#pragma once
+
+#include "../vec3.h"
+
+// Axis-aligned bounding box.
+class Aabb {
+ public:
+  Aabb();
+  Aabb(const Point3& a, const Point3& b);
+
+  Point3 get_min() const;
+  Point3 get_max() const;
+  Point3 centroid() const;
+
+ private:
+  Point3 minimum;
+  Point3 maximum;
+};
+
+Aabb surrounding_box(const Aabb& box0, const Aabb& box1);
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <memory>
+
 #include "../materials/material.h"
 #include "../ray.h"
+#include "../samplers/sampler.h"
 #include "../vec3.h"
+#include "aabb.h"
 
 struct HitRecord {
   // Point where the hit happens.
@@ -15,6 +19,14 @@ struct HitRecord {
   bool front_face;
   // Material hit.
   std::shared_ptr<Material> material;
+  // Texture coordinates of the point hit.
+  double u = 0;
+  double v = 0;
+  // Width of the ray's footprint at the hit in texture coordinates, which
+  // selects the texture detail to use.
+  double footprint = 0;
+  // Index of the top-level object hit, set by WideBvh. -1 if unknown.
+  int object_id = -1;
 
   void set_face_normal(const Ray& r, const Vec3& outward_normal) {
     front_face = dot(r.get_direction(), outward_normal) < 0;
@@ -22,11 +34,58 @@ struct HitRecord {
   }
 };
 
+// Direction towards a point on a light, picked for next-event estimation.
+struct LightSample {
+  // Unit length.
+  Vec3 direction;
+  // Distance to the light along direction.
+  double distance;
+  // Radiance the light sends back along direction.
+  Color radiance;
+  // Density of the direction over solid angle.
+  double pdf;
+};
+
 class Hittable {
  public:
   virtual bool hit(const Ray& r,
                    double t_min,
                    double t_max,
                    HitRecord& rec) const = 0;
+  // Whether anything is hit within [t_min, t_max], for shadow rays. Stops at
+  // the first hit found rather than searching for the closest one.
+  virtual bool hit_any(const Ray& r, double t_min, double t_max) const {
+    HitRecord rec;
+    return hit(r, t_min, t_max, rec);
+  }
+  // Returns false if the object has no bounding box.
+  virtual bool bounding_box(Aabb& output_box) const = 0;
+
+  // Light sampling. Objects that emit light return the power they emit,
+  // which sets how often they are sampled among the other lights.
+  virtual double emitted_power() const { return 0; }
+  // Surface area, or 0 if unknown.
+  virtual double area() const { return 0; }
+  // Picks a direction from origin towards an emitting surface of the object,
+  // using u in [0, 1) and jitter in the unit square. Returns false if there
+  // is none to pick, such as from inside a light. Only called on objects with
+  // emitted_power() > 0, except by an Instance that overrides the material
+  // of a single shape: shapes pick from their whole surface whatever their
+  // material, and the instance replaces the radiance.
+  virtual bool sample_light(const Point3& /* origin */,
+                            double /* u */,
+                            const Point2& /* jitter */,
+                            LightSample& /* sample */) const {
+    return false;
+  }
+  // Density over solid angle with which sample_light() picks direction from
+  // origin, given that the direction reaches the object at its emitting
+  // surface. object_id is the one hit() reported for that surface, or -1
+  // when an enclosing object overwrote it.
+  virtual double light_pdf(const Point3& /* origin */,
+                           const Vec3& /* direction */,
+                           int /* object_id */) const {
+    return 0;
+  }
   virtual ~Hittable(){};
 };
\ No newline at end of file
@@ -14,6 +14,11 @@ void HittableList::add(std::shared_ptr<Hittable> object) {
   this->objects.push_back(object);
 }
 
+const std::vector<std::shared_ptr<Hittable>>& HittableList::get_objects()
+    const {
+  return this->objects;
+}
+
 bool HittableList::hit(const Ray& r,
                        double t_min,
                        double t_max,
@@ -31,4 +36,32 @@ bool HittableList::hit(const Ray& r,
   }
 
   return hit_anything;
-}
\ No newline at end of file
+}
+
+bool HittableList::hit_any(const Ray& r, double t_min, double t_max) const {
+  for (const auto& object : objects) {
+    if (object->hit_any(r, t_min, t_max)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HittableList::bounding_box(Aabb& output_box) const {
+  if (objects.empty()) {
+    return false;
+  }
+
+  Aabb temp_box;
+  bool first_box = true;
+
+  for (const auto& object : objects) {
+    if (!object->bounding_box(temp_box)) {
+      return false;
+    }
+    output_box = first_box ? temp_box : surrounding_box(output_box, temp_box);
+    first_box = false;
+  }
+
+  return true;
+}
@@ -11,11 +11,16 @@ class HittableList : public Hittable {
 
   void clear();
   void add(std::shared_ptr<Hittable> object);
+  const std::vector<std::shared_ptr<Hittable>>& get_objects() const;
 
   virtual bool hit(const Ray& r,
                    double t_min,
                    double t_max,
                    HitRecord& rec) const override;
+  virtual bool hit_any(const Ray& r,
+                       double t_min,
+                       double t_max) const override;
+  virtual bool bounding_box(Aabb& output_box) const override;
 
  private:
   std::vector<std::shared_ptr<Hittable>> objects;
@@ -0,0 +1,128 @@
+#include "instance.h"
+#include <cmath>
+#include "../color.h"
+#include "../helpers.h"
+
+Instance::Instance(std::shared_ptr<Hittable> o,
+                   const Transform& t,
+                   std::shared_ptr<Material> m)
+    : object{o},
+      material{m},
+      object_to_world{t},
+      world_to_object{t.inverse()} {
+  scale = (object_to_world.apply_vector(Vec3(1, 0, 0)).length() +
+           object_to_world.apply_vector(Vec3(0, 1, 0)).length() +
+           object_to_world.apply_vector(Vec3(0, 0, 1)).length()) /
+          3;
+
+  Aabb object_box;
+  has_box = object->bounding_box(object_box);
+  if (!has_box) {
+    return;
+  }
+
+  // The world space box is the box around all eight transformed corners.
+  Point3 small(infinity, infinity, infinity);
+  Point3 big(-infinity, -infinity, -infinity);
+  for (int i = 0; i < 8; ++i) {
+    const Point3 corner(
+        (i & 1) ? object_box.get_max().get_x() : object_box.get_min().get_x(),
+        (i & 2) ? object_box.get_max().get_y() : object_box.get_min().get_y(),
+        (i & 4) ? object_box.get_max().get_z() : object_box.get_min().get_z());
+    const Point3 p = object_to_world.apply_point(corner);
+    small = Point3(fmin(small.get_x(), p.get_x()),
+                   fmin(small.get_y(), p.get_y()),
+                   fmin(small.get_z(), p.get_z()));
+    big = Point3(fmax(big.get_x(), p.get_x()),
+                 fmax(big.get_y(), p.get_y()),
+                 fmax(big.get_z(), p.get_z()));
+  }
+  box = Aabb(small, big);
+}
+
+bool Instance::hit(const Ray& r,
+                   double t_min,
+                   double t_max,
+                   HitRecord& rec) const {
+  // The object space direction is not normalized so that t is the same in both
+  // spaces.
+  Ray object_ray(world_to_object.apply_point(r.get_origin()),
+                 world_to_object.apply_vector(r.get_direction()));
+  // Widths shrink with the object, while angles do not change.
+  object_ray.set_cone(r.footprint(0) / scale, r.get_cone_spread());
+  if (!object->hit(object_ray, t_min, t_max, rec)) {
+    return false;
+  }
+
+  rec.point = r.at(rec.t);
+  // Normals transform by the inverse transpose of the object to world matrix.
+  // The face side does not change, so front_face is kept as is.
+  rec.normal = normalize(world_to_object.apply_transpose(rec.normal));
+  if (material) {
+    rec.material = material;
+  }
+  return true;
+}
+
+bool Instance::bounding_box(Aabb& output_box) const {
+  output_box = box;
+  return has_box;
+}
+
+bool Instance::hit_any(const Ray& r, double t_min, double t_max) const {
+  const Ray object_ray(world_to_object.apply_point(r.get_origin()),
+                       world_to_object.apply_vector(r.get_direction()));
+  return object->hit_any(object_ray, t_min, t_max);
+}
+
+double Instance::emitted_power() const {
+  if (!material) {
+    return object->emitted_power() * scale * scale;
+  }
+  return luminance(material->emitted()) * pi * area();
+}
+
+double Instance::area() const {
+  return object->area() * scale * scale;
+}
+
+bool Instance::sample_light(const Point3& origin,
+                            double u,
+                            const Point2& jitter,
+                            LightSample& sample) const {
+  // Without an override the object is a light itself. With one, only its
+  // shape is sampled and the override emits, so the object may not emit at
+  // all.
+  if (emitted_power() <= 0) {
+    return false;
+  }
+  LightSample local;
+  if (!object->sample_light(world_to_object.apply_point(origin), u, jitter,
+                            local)) {
+    return false;
+  }
+  const Vec3 direction = object_to_world.apply_vector(local.direction);
+  const double stretch = direction.length();
+  sample.direction = direction / stretch;
+  sample.distance = local.distance * stretch;
+  sample.radiance = material ? material->emitted() : local.radiance;
+  sample.pdf = local.pdf * solid_angle_ratio(stretch);
+  return true;
+}
+
+double Instance::light_pdf(const Point3& origin,
+                           const Vec3& direction,
+                           int object_id) const {
+  const Vec3 local_direction = world_to_object.apply_vector(direction);
+  const double local_pdf = object->light_pdf(
+      world_to_object.apply_point(origin), local_direction, object_id);
+  return local_pdf *
+         solid_angle_ratio(direction.length() / local_direction.length());
+}
+
+double Instance::solid_angle_ratio(double stretch) const {
+  // The object to world map M takes the cone of directions around a unit
+  // vector v to one around M v, with its solid angle multiplied by
+  // |det M| / |M v|^3. Densities divide by that.
+  return stretch * stretch * stretch * fabs(world_to_object.determinant());
+}
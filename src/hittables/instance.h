@@ -0,0 +1,48 @@
+#pragma once
+
+#include <memory>
+#include "../transform.h"
+#include "hittable.h"
+
+// Places shared geometry in the world through an affine transform. Many
+// instances can reference the same object, so memory grows with the amount of
+// unique geometry rather than with the number of copies in the scene.
+class Instance : public Hittable {
+ public:
+  // If material is set it overrides whatever the shared object reports. An
+  // emitting material should only override a single shape, such as a sphere,
+  // as the instance samples it as a light through the shape.
+  Instance(std::shared_ptr<Hittable> object,
+           const Transform& object_to_world,
+           std::shared_ptr<Material> material = nullptr);
+
+  bool hit(const Ray& r,
+           double t_min,
+           double t_max,
+           HitRecord& rec) const override;
+  bool hit_any(const Ray& r, double t_min, double t_max) const override;
+  bool bounding_box(Aabb& output_box) const override;
+  double emitted_power() const override;
+  double area() const override;
+  bool sample_light(const Point3& origin,
+                    double u,
+                    const Point2& jitter,
+                    LightSample& sample) const override;
+  double light_pdf(const Point3& origin,
+                   const Vec3& direction,
+                   int object_id) const override;
+
+ private:
+  // Density over world directions per unit of density over object
+  // directions, for a direction stretched by the given factor into the world.
+  double solid_angle_ratio(double stretch) const;
+
+  std::shared_ptr<Hittable> object;
+  std::shared_ptr<Material> material;
+  Transform object_to_world;
+  Transform world_to_object;
+  // Average length in the world of a unit length in the object.
+  double scale;
+  Aabb box;
+  bool has_box;
+};
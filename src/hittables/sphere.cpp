@@ -1,5 +1,7 @@
 #include "sphere.h"
 #include <cmath>
+#include "../color.h"
+#include "../helpers.h"
 
 Sphere::Sphere(Point3 c, double r, std::shared_ptr<Material> m)
     : center{c}, radius{r}, material{m} {}
@@ -32,6 +34,91 @@ bool Sphere::hit(const Ray& r,
   Vec3 outward_normal = (rec.point - center) / radius;
   rec.set_face_normal(r, outward_normal);
   rec.material = this->material;
+  // Latitude and longitude, with v = 0 at the bottom of the sphere.
+  rec.u = (atan2(-outward_normal.get_z(), outward_normal.get_x()) + pi) /
+          (2 * pi);
+  rec.v = acos(clamp(-outward_normal.get_y(), -1, 1)) / pi;
+  // A unit of v spans half the circumference, and a unit of u all of it.
+  rec.footprint = r.footprint(root) / (pi * radius);
 
   return true;
-}
\ No newline at end of file
+}
+
+bool Sphere::hit_any(const Ray& r, double t_min, double t_max) const {
+  const Vec3 oc = r.get_origin() - center;
+  const double a = r.get_direction().length_squared();
+  const double half_b = dot(oc, r.get_direction());
+  const double c = oc.length_squared() - radius * radius;
+  const double discriminant = half_b * half_b - a * c;
+  if (discriminant < 0) {
+    return false;
+  }
+  const double sqrtd = sqrt(discriminant);
+  const double near = (-half_b - sqrtd) / a;
+  const double far = (-half_b + sqrtd) / a;
+  return (near >= t_min && near <= t_max) || (far >= t_min && far <= t_max);
+}
+
+bool Sphere::bounding_box(Aabb& output_box) const {
+  const Vec3 extent(radius, radius, radius);
+  output_box = Aabb(center - extent, center + extent);
+  return true;
+}
+
+double Sphere::emitted_power() const {
+  // Every point sends out pi times its radiance.
+  return material ? luminance(material->emitted()) * pi * area() : 0;
+}
+
+double Sphere::area() const {
+  return 4 * pi * radius * radius;
+}
+
+bool Sphere::sample_light(const Point3& origin,
+                          double /* u */,
+                          const Point2& jitter,
+                          LightSample& sample) const {
+  // Uniform over the cone of directions in which origin sees the sphere.
+  const Vec3 to_center = center - origin;
+  const double distance_squared = to_center.length_squared();
+  const double radius_squared = radius * radius;
+  if (distance_squared <= radius_squared) {
+    return false;
+  }
+  const double sin_squared_max = radius_squared / distance_squared;
+  // 1 - cos(theta_max), written to keep its precision for distant spheres.
+  const double cone = sin_squared_max / (1 + sqrt(1 - sin_squared_max));
+  const double one_minus_cos = jitter.u * cone;
+  const double cos_theta = 1 - one_minus_cos;
+  const double sin_theta = sqrt(one_minus_cos * (2 - one_minus_cos));
+  const double phi = 2 * pi * jitter.v;
+
+  const double distance = sqrt(distance_squared);
+  const Vec3 w = to_center / distance;
+  const Vec3 helper = fabs(w.get_x()) > 0.9 ? Vec3(0, 1, 0) : Vec3(1, 0, 0);
+  const Vec3 v = normalize(cross(w, helper));
+  const Vec3 u = cross(w, v);
+
+  sample.direction = u * (cos(phi) * sin_theta) + v * (sin(phi) * sin_theta) +
+                     w * cos_theta;
+  // Nearest of the two points where the direction meets the sphere.
+  const double offset_squared =
+      radius_squared - distance_squared * sin_theta * sin_theta;
+  sample.distance = distance * cos_theta - sqrt(fmax(offset_squared, 0));
+  sample.radiance = material ? material->emitted() : Color{0, 0, 0};
+  sample.pdf = 1 / (2 * pi * cone);
+  return true;
+}
+
+double Sphere::light_pdf(const Point3& origin,
+                         const Vec3& /* direction */,
+                         int /* object_id */) const {
+  // Every direction in the cone is as likely.
+  const double distance_squared = (center - origin).length_squared();
+  const double radius_squared = radius * radius;
+  if (distance_squared <= radius_squared) {
+    return 0;
+  }
+  const double sin_squared_max = radius_squared / distance_squared;
+  return 1 / (2 * pi * sin_squared_max / (1 + sqrt(1 - sin_squared_max)));
+}
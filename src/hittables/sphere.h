@@ -10,6 +10,17 @@ class Sphere : public Hittable {
            double t_min,
            double t_max,
            HitRecord& rec) const override;
+  bool hit_any(const Ray& r, double t_min, double t_max) const override;
+  bool bounding_box(Aabb& output_box) const override;
+  double emitted_power() const override;
+  double area() const override;
+  bool sample_light(const Point3& origin,
+                    double u,
+                    const Point2& jitter,
+                    LightSample& sample) const override;
+  double light_pdf(const Point3& origin,
+                   const Vec3& direction,
+                   int object_id) const override;
 
  private:
   Point3 center;
@@ -0,0 +1,405 @@
+#include "wide_bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "../helpers.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Deepest stack a traversal can need: trees are balanced, and every node
+// visited pushes at most width - 1 more entries than it pops.
+const int max_stack = 256;
+
+double surface_area(const Aabb& box) {
+  const Vec3 d = box.get_max() - box.get_min();
+  return d.get_x() * d.get_y() + d.get_y() * d.get_z() +
+         d.get_z() * d.get_x();
+}
+
+float power_of_two(uint8_t biased_exponent) {
+  const uint32_t bits = static_cast<uint32_t>(biased_exponent) << 23;
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+WideBvh::WideBvh(const HittableList& list)
+    : objects{list.get_objects()}, total_power{0} {
+  if (objects.empty()) {
+    throw std::invalid_argument("WideBvh requires at least one object");
+  }
+
+  std::vector<Aabb> boxes(objects.size());
+  std::vector<int> order(objects.size());
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (!objects[i]->bounding_box(boxes[i])) {
+      throw std::invalid_argument(
+          "WideBvh requires objects with bounding boxes");
+    }
+    order[i] = i;
+  }
+
+  std::vector<BuildNode> tree;
+  tree.reserve(2 * objects.size());
+  const int root = build_binary(boxes, order, 0, objects.size(), tree);
+  box = tree[root].box;
+  build_node(tree, root);
+
+  std::vector<double> powers;
+  for (size_t i = 0; i < objects.size(); ++i) {
+    const double power = objects[i]->emitted_power();
+    if (power > 0) {
+      lights.push_back(i);
+      powers.push_back(power);
+      total_power += power;
+    }
+  }
+  if (!lights.empty()) {
+    light_index.assign(objects.size(), -1);
+    for (size_t i = 0; i < lights.size(); ++i) {
+      light_index[lights[i]] = i;
+    }
+    light_table.reset(new AliasTable(powers));
+  }
+}
+
+int WideBvh::build_binary(const std::vector<Aabb>& boxes,
+                          std::vector<int>& order,
+                          size_t start,
+                          size_t end,
+                          std::vector<BuildNode>& tree) {
+  if (end - start == 1) {
+    tree.push_back(BuildNode{boxes[order[start]], -1, -1, order[start]});
+    return tree.size() - 1;
+  }
+
+  const Point3 first = boxes[order[start]].centroid();
+  Aabb centroid_box(first, first);
+  for (size_t i = start + 1; i < end; ++i) {
+    const Point3 c = boxes[order[i]].centroid();
+    centroid_box = surrounding_box(centroid_box, Aabb(c, c));
+  }
+  const Vec3 extent = centroid_box.get_max() - centroid_box.get_min();
+  int axis = 0;
+  if (extent.get_y() > extent[axis]) {
+    axis = 1;
+  }
+  if (extent.get_z() > extent[axis]) {
+    axis = 2;
+  }
+
+  const size_t mid = start + (end - start) / 2;
+  std::nth_element(order.begin() + start, order.begin() + mid,
+                   order.begin() + end, [&](int a, int b) {
+                     return boxes[a].centroid()[axis] <
+                            boxes[b].centroid()[axis];
+                   });
+
+  const int left = build_binary(boxes, order, start, mid, tree);
+  const int right = build_binary(boxes, order, mid, end, tree);
+  tree.push_back(BuildNode{
+      surrounding_box(tree[left].box, tree[right].box), left, right, -1});
+  return tree.size() - 1;
+}
+
+int WideBvh::build_node(const std::vector<BuildNode>& tree, int index) {
+  // Open the child with the largest surface area until there are width
+  // children or only leaves are left.
+  std::vector<int> children;
+  if (tree[index].object >= 0) {
+    children.push_back(index);
+  } else {
+    children.push_back(tree[index].left);
+    children.push_back(tree[index].right);
+  }
+  while (children.size() < static_cast<size_t>(width)) {
+    int best = -1;
+    double best_area = -1;
+    for (size_t i = 0; i < children.size(); ++i) {
+      const BuildNode& child = tree[children[i]];
+      if (child.object < 0 && surface_area(child.box) > best_area) {
+        best = i;
+        best_area = surface_area(child.box);
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    const BuildNode& opened = tree[children[best]];
+    children[best] = opened.left;
+    children.push_back(opened.right);
+  }
+
+  Node node;
+  std::memset(&node, 0, sizeof(node));
+  node.child_count = children.size();
+  const Point3 lower = tree[index].box.get_min();
+  const Point3 upper = tree[index].box.get_max();
+  for (int axis = 0; axis < 3; ++axis) {
+    float origin = static_cast<float>(lower[axis]);
+    if (origin > lower[axis]) {
+      origin = std::nextafter(origin, -std::numeric_limits<float>::infinity());
+    }
+    // Smallest power of two spacing whose 255 cells cover the box.
+    const double extent = upper[axis] - origin;
+    int exponent = extent > 0 ? std::ilogb(extent / 255) : -126;
+    exponent = std::max(exponent, -126);
+    while (std::ldexp(255.0, exponent) < extent) {
+      ++exponent;
+    }
+    if (exponent > 127) {
+      throw std::invalid_argument("WideBvh scene is too large");
+    }
+    node.origin[axis] = origin;
+    node.exponent[axis] = exponent + 127;
+
+    const double cell = std::ldexp(1.0, exponent);
+    for (size_t i = 0; i < children.size(); ++i) {
+      const Aabb& child = tree[children[i]].box;
+      const double lo = std::floor((child.get_min()[axis] - origin) / cell);
+      const double hi = std::ceil((child.get_max()[axis] - origin) / cell);
+      node.lower[axis][i] = std::min(std::max(lo, 0.0), 255.0);
+      node.upper[axis][i] = std::min(std::max(hi, 0.0), 255.0);
+    }
+  }
+
+  // Children are built after their parent, so nodes are in depth-first order.
+  const int node_index = nodes.size();
+  nodes.push_back(node);
+  for (size_t i = 0; i < children.size(); ++i) {
+    const BuildNode& child = tree[children[i]];
+    const int32_t encoded =
+        child.object >= 0 ? ~child.object : build_node(tree, children[i]);
+    nodes[node_index].child[i] = encoded;
+  }
+  return node_index;
+}
+
+bool WideBvh::hit(const Ray& r,
+                  double t_min,
+                  double t_max,
+                  HitRecord& rec) const {
+  float origin[3];
+  float inv_direction[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    origin[axis] = r.get_origin()[axis];
+    // Large but finite, so that a ray in a slab plane gives 0 and not NaN.
+    const double inv = 1.0 / r.get_direction()[axis];
+    inv_direction[axis] =
+        std::fabs(inv) < 1e30 ? inv : std::copysign(1e30, inv);
+  }
+
+  struct Entry {
+    int node;
+    float t_enter;
+  };
+  Entry stack[max_stack];
+  int size = 0;
+  stack[size++] = Entry{0, static_cast<float>(t_min)};
+
+  bool hit_anything = false;
+  double closest = t_max;
+  while (size > 0) {
+    const Entry entry = stack[--size];
+    if (entry.t_enter > closest) {
+      continue;
+    }
+    const Node& node = nodes[entry.node];
+    float t_enter[width];
+    const int mask =
+        intersect_children(node, origin, inv_direction, t_min, closest,
+                           t_enter);
+    if (mask == 0) {
+      continue;
+    }
+
+    // Children the ray enters, nearest first.
+    int order[width];
+    int count = 0;
+    for (int i = 0; i < node.child_count; ++i) {
+      if (mask & (1 << i)) {
+        int j = count++;
+        for (; j > 0 && t_enter[order[j - 1]] > t_enter[i]; --j) {
+          order[j] = order[j - 1];
+        }
+        order[j] = i;
+      }
+    }
+
+    // Test objects right away, which may shorten the ray before the child
+    // nodes are pushed. Push the nodes farthest first so the nearest is
+    // visited next.
+    for (int j = 0; j < count; ++j) {
+      const int32_t child = node.child[order[j]];
+      if (child < 0 && t_enter[order[j]] <= closest &&
+          objects[~child]->hit(r, t_min, closest, rec)) {
+        hit_anything = true;
+        closest = rec.t;
+        rec.object_id = ~child;
+      }
+    }
+    for (int j = count - 1; j >= 0; --j) {
+      const int32_t child = node.child[order[j]];
+      if (child >= 0 && t_enter[order[j]] <= closest) {
+        stack[size++] = Entry{child, t_enter[order[j]]};
+      }
+    }
+  }
+  return hit_anything;
+}
+
+bool WideBvh::hit_any(const Ray& r, double t_min, double t_max) const {
+  float origin[3];
+  float inv_direction[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    origin[axis] = r.get_origin()[axis];
+    const double inv = 1.0 / r.get_direction()[axis];
+    inv_direction[axis] =
+        std::fabs(inv) < 1e30 ? inv : std::copysign(1e30, inv);
+  }
+
+  // Any hit will do, so children are visited in node order and the search
+  // ends at the first object hit.
+  int stack[max_stack];
+  int size = 0;
+  stack[size++] = 0;
+  while (size > 0) {
+    const Node& node = nodes[stack[--size]];
+    float t_enter[width];
+    const int mask = intersect_children(node, origin, inv_direction, t_min,
+                                        t_max, t_enter);
+    for (int i = 0; i < node.child_count; ++i) {
+      if (!(mask & (1 << i))) {
+        continue;
+      }
+      const int32_t child = node.child[i];
+      if (child >= 0) {
+        stack[size++] = child;
+      } else if (objects[~child]->hit_any(r, t_min, t_max)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+int WideBvh::intersect_children(const Node& node,
+                                const float origin[3],
+                                const float inv_direction[3],
+                                float t_min,
+                                float t_max,
+                                float t_enter[width]) const {
+  // Widens the exit distance by a few float ulps to make up for rounding in
+  // the decoded planes, so boxes are never missed by a hair.
+  const float widen = 1 + 4 * std::numeric_limits<float>::epsilon();
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  // Converts four cell indices to floats.
+  auto load = [zero](const uint8_t* cells) {
+    int32_t packed;
+    std::memcpy(&packed, cells, sizeof(packed));
+    __m128i v = _mm_cvtsi32_si128(packed);
+    v = _mm_unpacklo_epi8(v, zero);
+    v = _mm_unpacklo_epi16(v, zero);
+    return _mm_cvtepi32_ps(v);
+  };
+
+  __m128 t_near = _mm_set1_ps(t_min);
+  __m128 t_far = _mm_set1_ps(t_max);
+  for (int axis = 0; axis < 3; ++axis) {
+    const __m128 cell = _mm_set1_ps(power_of_two(node.exponent[axis]));
+    // Offset of the grid from the ray origin.
+    const __m128 base = _mm_set1_ps(node.origin[axis] - origin[axis]);
+    const __m128 inv = _mm_set1_ps(inv_direction[axis]);
+    const __m128 t0 = _mm_mul_ps(
+        _mm_add_ps(base, _mm_mul_ps(load(node.lower[axis]), cell)), inv);
+    const __m128 t1 = _mm_mul_ps(
+        _mm_add_ps(base, _mm_mul_ps(load(node.upper[axis]), cell)), inv);
+    t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+    t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+  }
+  t_far = _mm_mul_ps(t_far, _mm_set1_ps(widen));
+  _mm_storeu_ps(t_enter, t_near);
+  const int mask = _mm_movemask_ps(_mm_cmple_ps(t_near, t_far));
+#else
+  int mask = 0;
+  for (int i = 0; i < width; ++i) {
+    float t_near = t_min;
+    float t_far = t_max;
+    for (int axis = 0; axis < 3; ++axis) {
+      const float cell = power_of_two(node.exponent[axis]);
+      const float base = node.origin[axis] - origin[axis];
+      const float inv = inv_direction[axis];
+      const float t0 = (base + node.lower[axis][i] * cell) * inv;
+      const float t1 = (base + node.upper[axis][i] * cell) * inv;
+      t_near = std::max(t_near, std::min(t0, t1));
+      t_far = std::min(t_far, std::max(t0, t1));
+    }
+    t_enter[i] = t_near;
+    mask |= (t_near <= t_far * widen) << i;
+  }
+#endif
+  return mask & ((1 << node.child_count) - 1);
+}
+
+bool WideBvh::bounding_box(Aabb& output_box) const {
+  output_box = box;
+  return true;
+}
+
+double WideBvh::emitted_power() const {
+  return total_power;
+}
+
+bool WideBvh::sample_light(const Point3& origin,
+                           double u,
+                           const Point2& jitter,
+                           LightSample& sample) const {
+  if (!light_table) {
+    return false;
+  }
+  // The light gets what is left of u, so that lights which use it do not
+  // see a value tied to their own index.
+  double remapped;
+  const int light = light_table->sample(u, remapped);
+  if (!objects[lights[light]]->sample_light(origin, remapped, jitter,
+                                            sample)) {
+    return false;
+  }
+  sample.pdf *= light_table->pmf(light);
+  return true;
+}
+
+double WideBvh::light_pdf(const Point3& origin,
+                          const Vec3& direction,
+                          int object_id) const {
+  if (!light_table) {
+    return 0;
+  }
+  if (object_id < 0) {
+    // Called through an instance, whose hit reported the id of the level
+    // above. Find the surface again, with the same bounds as a bounce ray.
+    HitRecord rec;
+    if (!hit(Ray(origin, direction), 0.001, infinity, rec)) {
+      return 0;
+    }
+    object_id = rec.object_id;
+  }
+  if (light_index[object_id] < 0) {
+    return 0;
+  }
+  return light_table->pmf(light_index[object_id]) *
+         objects[object_id]->light_pdf(origin, direction, -1);
+}
+
+size_t WideBvh::node_bytes() const {
+  return nodes.size() * sizeof(Node);
+}
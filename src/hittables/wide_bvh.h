@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../alias_table.h"
+#include "hittable.h"
+#include "hittable_list.h"
+
+// Bounding volume hierarchy with four children per node. Child boxes are
+// stored as 8-bit offsets on a per-node grid spanning the node's box, rounded
+// outwards, so a node fits in 56 bytes and all four boxes are tested at once.
+// Nodes sit in one array in depth-first order, which puts the first child of a
+// node right after it in memory.
+//
+// Building one over a list of instances and another over each piece of shared
+// geometry gives a two-level structure. Hits report the index of the object in
+// the list as their object_id, which the level above overwrites, so a nested
+// BVH of lights traces the ray again to find the light for light_pdf().
+//
+// The objects that emit light are kept in an alias table weighted by their
+// power, so a light is picked in constant time however many there are.
+class WideBvh : public Hittable {
+ public:
+  static const int width = 4;
+
+  WideBvh(const HittableList& list);
+
+  bool hit(const Ray& r,
+           double t_min,
+           double t_max,
+           HitRecord& rec) const override;
+  bool hit_any(const Ray& r, double t_min, double t_max) const override;
+  bool bounding_box(Aabb& output_box) const override;
+  double emitted_power() const override;
+  // Picks a light with u, then a direction towards it with jitter.
+  bool sample_light(const Point3& origin,
+                    double u,
+                    const Point2& jitter,
+                    LightSample& sample) const override;
+  double light_pdf(const Point3& origin,
+                   const Vec3& direction,
+                   int object_id) const override;
+
+  // Memory taken by the nodes, not counting the objects.
+  size_t node_bytes() const;
+
+ private:
+  struct Node {
+    // Corner of the node's grid, rounded down to float.
+    float origin[3];
+    // Grid spacing per axis, as the biased exponent of a power of two.
+    uint8_t exponent[3];
+    uint8_t child_count;
+    // Grid cells bounding each child, per axis.
+    uint8_t lower[3][width];
+    uint8_t upper[3][width];
+    // Index of a child node, or the bitwise complement of an object index.
+    int32_t child[width];
+  };
+
+  // Node of the binary tree the wide nodes are collapsed from.
+  struct BuildNode {
+    Aabb box;
+    int left;
+    int right;
+    // Index of the object in a leaf, -1 for inner nodes.
+    int object;
+  };
+
+  // Splits at the median centroid along the longest axis of the centroids
+  // and returns the index of the subtree in tree.
+  static int build_binary(const std::vector<Aabb>& boxes,
+                          std::vector<int>& order,
+                          size_t start,
+                          size_t end,
+                          std::vector<BuildNode>& tree);
+  // Collapses the binary subtree at index into wide nodes and returns the
+  // index of its root node.
+  int build_node(const std::vector<BuildNode>& tree, int index);
+  // Returns a mask of the children whose boxes the ray enters within
+  // [t_min, t_max], with their entry distances in t_enter.
+  int intersect_children(const Node& node,
+                         const float origin[3],
+                         const float inv_direction[3],
+                         float t_min,
+                         float t_max,
+                         float t_enter[width]) const;
+
+  std::vector<std::shared_ptr<Hittable>> objects;
+  std::vector<Node> nodes;
+  Aabb box;
+  // Objects that emit light, and each object's index among them or -1. Null
+  // and empty without lights.
+  std::vector<int> lights;
+  std::vector<int> light_index;
+  std::unique_ptr<AliasTable> light_table;
+  double total_power;
+};
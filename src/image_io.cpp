@@ -0,0 +1,87 @@
+#include "image_io.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+bool is_little_endian() {
+  const uint16_t one = 1;
+  unsigned char first_byte;
+  std::memcpy(&first_byte, &one, 1);
+  return first_byte == 1;
+}
+
+float swap_bytes(float value) {
+  unsigned char bytes[4];
+  std::memcpy(bytes, &value, 4);
+  std::swap(bytes[0], bytes[3]);
+  std::swap(bytes[1], bytes[2]);
+  std::memcpy(&value, bytes, 4);
+  return value;
+}
+
+}  // namespace
+
+void write_pfm(const std::string& path,
+               int width,
+               int height,
+               const std::vector<Color>& pixels) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Cannot open " + path);
+  }
+
+  // A negative scale marks little endian data.
+  out << "PF\n" << width << " " << height << "\n"
+      << (is_little_endian() ? "-1.0" : "1.0") << "\n";
+
+  std::vector<float> row(3 * width);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const Color& c = pixels[y * width + x];
+      row[3 * x] = static_cast<float>(c.get_x());
+      row[3 * x + 1] = static_cast<float>(c.get_y());
+      row[3 * x + 2] = static_cast<float>(c.get_z());
+    }
+    out.write(reinterpret_cast<const char*>(row.data()),
+              row.size() * sizeof(float));
+  }
+  if (!out) {
+    throw std::runtime_error("Cannot write " + path);
+  }
+}
+
+bool read_pfm(const std::string& path,
+              int& width,
+              int& height,
+              std::vector<Color>& pixels) {
+  std::ifstream in(path, std::ios::binary);
+  std::string magic;
+  double scale;
+  if (!(in >> magic >> width >> height >> scale) || magic != "PF" ||
+      width <= 0 || height <= 0) {
+    return false;
+  }
+  // Exactly one whitespace character separates the header from the data.
+  in.get();
+
+  const bool swap = (scale < 0) != is_little_endian();
+  std::vector<float> data(3 * static_cast<size_t>(width) * height);
+  if (!in.read(reinterpret_cast<char*>(data.data()),
+               data.size() * sizeof(float))) {
+    return false;
+  }
+
+  pixels.resize(static_cast<size_t>(width) * height);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    float rgb[3] = {data[3 * i], data[3 * i + 1], data[3 * i + 2]};
+    for (float& v : rgb) {
+      v = swap ? swap_bytes(v) : v;
+    }
+    pixels[i] = Color(rgb[0], rgb[1], rgb[2]);
+  }
+  return true;
+}
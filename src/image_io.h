@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "vec3.h"
+
+// Reads and writes linear color images as PFM: 32 bit floats, rows from the
+// bottom of the image up, which matches the framebuffer layout.
+
+// Throws std::runtime_error if the file cannot be written.
+void write_pfm(const std::string& path,
+               int width,
+               int height,
+               const std::vector<Color>& pixels);
+// Returns false if the file is missing or not a color PFM.
+bool read_pfm(const std::string& path,
+              int& width,
+              int& height,
+              std::vector<Color>& pixels);
@@ -2,13 +2,15 @@
 #include <cmath>
 #include "../helpers.h"
 #include "../hittables/hittable.h"
+#include "../samplers/sampler.h"
 
 Dielectric::Dielectric(double ior) : index_of_refraction{ior} {}
 
 bool Dielectric::scatter(const Ray& r_in,
                          const HitRecord& rec,
                          Color& attenuation,
-                         Ray& scattered) const {
+                         Ray& scattered,
+                         Sampler& sampler) const {
   attenuation = Color(1.0, 1.0, 1.0);
   double refraction_ratio =
       rec.front_face ? (1.0 / index_of_refraction) : index_of_refraction;
@@ -18,10 +20,11 @@ bool Dielectric::scatter(const Ray& r_in,
   double sin_theta = sqrt(1.0 - cos_theta * cos_theta);
 
   bool cannot_refract = refraction_ratio * sin_theta > 1.0;
+  // Always draw the sample so every path uses the same number of dimensions.
+  const double choice = sampler.get_1d();
   Vec3 direction;
 
-  if (cannot_refract ||
-      reflectance(cos_theta, refraction_ratio) > random_double()) {
+  if (cannot_refract || reflectance(cos_theta, refraction_ratio) > choice) {
     direction = reflect(unit_direction, rec.normal);
   } else {
     direction = refract(unit_direction, rec.normal, refraction_ratio);
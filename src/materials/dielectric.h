@@ -7,7 +7,8 @@ class Dielectric : public Material {
   virtual bool scatter(const Ray& r_in,
                        const HitRecord& rec,
                        Color& attenuation,
-                       Ray& scattered) const override;
+                       Ray& scattered,
+                       Sampler& sampler) const override;
 
  private:
   double index_of_refraction;
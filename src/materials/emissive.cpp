@@ -0,0 +1,15 @@
+#include "emissive.h"
+
+Emissive::Emissive(const Color& r) : radiance{r} {}
+
+bool Emissive::scatter(const Ray& /* r_in */,
+                       const HitRecord& /* rec */,
+                       Color& /* attenuation */,
+                       Ray& /* scattered */,
+                       Sampler& /* sampler */) const {
+  return false;
+}
+
+Color Emissive::emitted() const {
+  return radiance;
+}
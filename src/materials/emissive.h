@@ -0,0 +1,20 @@
+#pragma once
+
+#include "material.h"
+
+// Surface that gives off light and scatters none. Only the front face emits,
+// which for a sphere is the outside.
+class Emissive : public Material {
+ public:
+  Emissive(const Color& radiance);
+
+  virtual bool scatter(const Ray& r_in,
+                       const HitRecord& rec,
+                       Color& attenuation,
+                       Ray& scattered,
+                       Sampler& sampler) const override;
+  virtual Color emitted() const override;
+
+ private:
+  Color radiance;
+};
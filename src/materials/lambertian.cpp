@@ -1,19 +1,44 @@
 #include "lambertian.h"
+#include "../helpers.h"
 #include "../hittables/hittable.h"
+#include "../samplers/sampler.h"
+#include "../textures/solid_color.h"
 
-Lambertian::Lambertian(const Color& a) : albedo{a} {}
+Lambertian::Lambertian(const Color& a)
+    : albedo{std::make_shared<SolidColor>(a)} {}
+
+Lambertian::Lambertian(std::shared_ptr<Texture> a) : albedo{a} {}
 
 bool Lambertian::scatter(const Ray& r_in,
                          const HitRecord& rec,
                          Color& attenuation,
-                         Ray& scattered) const {
-  Vec3 scatter_direction = rec.normal + random_unit_vector();
+                         Ray& scattered,
+                         Sampler& sampler) const {
+  const Point2 u = sampler.get_2d();
+  Vec3 scatter_direction = rec.normal + sample_unit_vector(u.u, u.v);
 
   if (scatter_direction.near_zero()) {
     scatter_direction = rec.normal;
   }
 
   scattered = Ray(rec.point, scatter_direction);
-  attenuation = albedo;
+  attenuation = albedo->value(rec.u, rec.v, rec.footprint);
+  return true;
+}
+bool Lambertian::is_diffuse() const {
   return true;
-}
\ No newline at end of file
+}
+
+Color Lambertian::eval(const Ray&,
+                       const HitRecord& rec,
+                       const Vec3& direction,
+                       double& pdf) const {
+  // scatter() picks directions with a cosine-weighted density.
+  const double cosine = dot(normalize(direction), rec.normal);
+  if (cosine <= 0) {
+    pdf = 0;
+    return Color{0, 0, 0};
+  }
+  pdf = cosine / pi;
+  return albedo->value(rec.u, rec.v, rec.footprint) * pdf;
+}
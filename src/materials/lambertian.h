@@ -1,14 +1,23 @@
+#include <memory>
+#include "../textures/texture.h"
 #include "material.h"
 
 class Lambertian : public Material {
  public:
   Lambertian(const Color& a);
+  Lambertian(std::shared_ptr<Texture> a);
 
   virtual bool scatter(const Ray& r_in,
                        const HitRecord& rec,
                        Color& attenuation,
-                       Ray& scattered) const override;
+                       Ray& scattered,
+                       Sampler& sampler) const override;
+  virtual Color eval(const Ray& r_in,
+                     const HitRecord& rec,
+                     const Vec3& direction,
+                     double& pdf) const override;
+  virtual bool is_diffuse() const override;
 
  public:
-  Color albedo;
+  std::shared_ptr<Texture> albedo;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../ray.h"
 
 struct HitRecord;
+class Sampler;
 
 class Material {
  public:
@@ -10,6 +11,24 @@ class Material {
   virtual bool scatter(const Ray& ray_in,
                        const HitRecord& hit_record,
                        Color& attenuation,
-                       Ray& scattered) const = 0;
+                       Ray& scattered,
+                       Sampler& sampler) const = 0;
+  // True if the scattered light does not depend on the incoming direction,
+  // so the light arriving at the surface can be shared between paths.
+  virtual bool is_diffuse() const { return false; }
+  // Light scattered towards the viewer per unit of light arriving from
+  // direction (the BSDF times the cosine term), and in pdf the density with
+  // which scatter() picks that direction. Both are 0 for materials that
+  // scatter into a finite set of directions, such as mirrors and glass.
+  virtual Color eval(const Ray& /* ray_in */,
+                     const HitRecord& /* hit_record */,
+                     const Vec3& /* direction */,
+                     double& pdf) const {
+    pdf = 0;
+    return Color{0, 0, 0};
+  }
+  // Radiance leaving the front face of the surface, the same at every point
+  // and in every direction.
+  virtual Color emitted() const { return Color{0, 0, 0}; }
   virtual ~Material(){};
 };
\ No newline at end of file
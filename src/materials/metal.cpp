@@ -1,15 +1,56 @@
 #include "metal.h"
+#include <algorithm>
+#include <cmath>
+#include "../helpers.h"
 #include "../hittables/hittable.h"
 #include "../ray.h"
+#include "../samplers/sampler.h"
+#include "../textures/solid_color.h"
 
-Metal::Metal(const Color& a, double f) : albedo{a}, fuzz{f} {}
+Metal::Metal(const Color& a, double f)
+    : albedo{std::make_shared<SolidColor>(a)}, fuzz{f} {}
+
+Metal::Metal(std::shared_ptr<Texture> a, double f) : albedo{a}, fuzz{f} {}
 
 bool Metal::scatter(const Ray& r_in,
                     const HitRecord& rec,
                     Color& attenuation,
-                    Ray& scattered) const {
+                    Ray& scattered,
+                    Sampler& sampler) const {
   Vec3 reflected = reflect(normalize(r_in.get_direction()), rec.normal);
-  scattered = Ray(rec.point, reflected + fuzz * random_in_unit_sphere());
-  attenuation = albedo;
+  const Point2 u = sampler.get_2d();
+  const Vec3 perturbation = sample_in_unit_sphere(u.u, u.v, sampler.get_1d());
+  scattered = Ray(rec.point, reflected + fuzz * perturbation);
+  attenuation = albedo->value(rec.u, rec.v, rec.footprint);
   return (dot(scattered.get_direction(), rec.normal) > 0);
-}
\ No newline at end of file
+}
+
+Color Metal::eval(const Ray& r_in,
+                  const HitRecord& rec,
+                  const Vec3& direction,
+                  double& pdf) const {
+  pdf = 0;
+  const Vec3 d = normalize(direction);
+  if (fuzz <= 0 || dot(d, rec.normal) <= 0) {
+    return Color{0, 0, 0};
+  }
+
+  // scatter() aims at a point uniform in a ball of radius fuzz around the
+  // unit mirror direction. The density of a direction is the ball's volume
+  // along that direction, weighted by t^2, over the ball's whole volume.
+  const Vec3 reflected = reflect(normalize(r_in.get_direction()), rec.normal);
+  const double b = dot(d, reflected);
+  const double discriminant = b * b - (1 - fuzz * fuzz);
+  if (discriminant <= 0) {
+    return Color{0, 0, 0};
+  }
+  const double far = b + sqrt(discriminant);
+  const double near = std::max(b - sqrt(discriminant), 0.0);
+  if (far <= 0) {
+    return Color{0, 0, 0};
+  }
+  pdf = (far * far * far - near * near * near) / (4 * pi * fuzz * fuzz * fuzz);
+  // Every direction scatter() keeps carries the albedo, so the BSDF times
+  // the cosine is the albedo times the density.
+  return albedo->value(rec.u, rec.v, rec.footprint) * pdf;
+}
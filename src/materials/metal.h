@@ -1,15 +1,23 @@
+#include <memory>
+#include "../textures/texture.h"
 #include "material.h"
 
 class Metal : public Material {
  public:
   Metal(const Color& a, double f);
+  Metal(std::shared_ptr<Texture> a, double f);
 
   virtual bool scatter(const Ray& r_in,
                        const HitRecord& rec,
                        Color& attenuation,
-                       Ray& scattered) const override;
+                       Ray& scattered,
+                       Sampler& sampler) const override;
+  virtual Color eval(const Ray& r_in,
+                     const HitRecord& rec,
+                     const Vec3& direction,
+                     double& pdf) const override;
 
  public:
-  Color albedo;
+  std::shared_ptr<Texture> albedo;
   double fuzz;
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include "multi_view.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include "helpers.h"
+
+std::vector<CameraSetup> stereo_pair(const CameraSetup& setup,
+                                     double eye_separation) {
+  const Vec3 w = normalize(setup.lookfrom - setup.lookat);
+  const Vec3 u = normalize(cross(setup.vup, w));
+  const Vec3 offset = (eye_separation / 2) * u;
+
+  CameraSetup left = setup;
+  left.lookfrom = setup.lookfrom - offset;
+  CameraSetup right = setup;
+  right.lookfrom = setup.lookfrom + offset;
+  return {left, right};
+}
+
+std::vector<CameraSetup> cube_map(const CameraSetup& setup) {
+  const Point3 p = setup.lookfrom;
+  const Vec3 directions[] = {Vec3(1, 0, 0),  Vec3(-1, 0, 0), Vec3(0, 1, 0),
+                             Vec3(0, -1, 0), Vec3(0, 0, 1),  Vec3(0, 0, -1)};
+  const Vec3 ups[] = {Vec3(0, 1, 0),  Vec3(0, 1, 0), Vec3(0, 0, -1),
+                      Vec3(0, 0, 1),  Vec3(0, 1, 0), Vec3(0, 1, 0)};
+
+  std::vector<CameraSetup> faces;
+  for (int i = 0; i < 6; ++i) {
+    faces.push_back(CameraSetup{p, p + directions[i], ups[i], 90, 0.0, 1.0});
+  }
+  return faces;
+}
+
+std::vector<CameraSetup> turntable(const CameraSetup& setup, int count) {
+  const Vec3 axis = normalize(setup.vup);
+  const Vec3 arm = setup.lookfrom - setup.lookat;
+
+  std::vector<CameraSetup> views;
+  for (int i = 0; i < count; ++i) {
+    // Rodrigues' rotation of the arm around the axis.
+    const double theta = 2 * pi * i / count;
+    const Vec3 rotated = cos(theta) * arm + sin(theta) * cross(axis, arm) +
+                         (1 - cos(theta)) * dot(axis, arm) * axis;
+    CameraSetup view = setup;
+    view.lookfrom = setup.lookat + rotated;
+    views.push_back(view);
+  }
+  return views;
+}
+
+std::vector<CameraSetup> make_view_set(const std::string& spec,
+                                       const CameraSetup& setup) {
+  if (spec == "stereo") {
+    // About the distance between human eyes, with scene units as meters.
+    return stereo_pair(setup, 0.065);
+  } else if (spec == "cube") {
+    return cube_map(setup);
+  } else if (spec.compare(0, 10, "turntable:") == 0) {
+    const int count = std::stoi(spec.substr(10));
+    if (count > 0) {
+      return turntable(setup, count);
+    }
+  }
+  throw std::invalid_argument("Unknown view set: " + spec);
+}
+
+std::vector<View> make_views(const std::string& spec,
+                             const CameraSetup& setup,
+                             double aspect_ratio,
+                             const std::string& prefix) {
+  std::vector<View> views;
+  for (const CameraSetup& view : make_view_set(spec, setup)) {
+    views.push_back(View{
+        view.to_camera(aspect_ratio),
+        prefix + "_" + std::to_string(views.size()) + ".ppm"});
+  }
+  return views;
+}
+
+RenderStats render_views(ThreadPool& pool,
+                         const RenderSettings& settings,
+                         std::shared_ptr<const Hittable> world,
+                         const std::vector<View>& views) {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::unique_ptr<Renderer>> renderers;
+  std::vector<std::function<void()>> tasks;
+  for (const View& view : views) {
+    renderers.emplace_back(new Renderer(settings, world, view.camera));
+    // Diffuse lighting does not depend on the view, so views share a cache.
+    if (renderers.size() > 1) {
+      renderers.back()->set_radiance_cache(
+          renderers.front()->get_radiance_cache());
+    }
+    renderers.back()->add_render_tasks(tasks);
+  }
+  pool.run(tasks);
+
+  RenderStats total{0, 0, 0, 0, 0};
+  for (size_t i = 0; i < views.size(); ++i) {
+    std::ofstream out(views[i].output);
+    if (!out) {
+      throw std::runtime_error("Cannot open " + views[i].output);
+    }
+    renderers[i]->write_ppm(out);
+
+    const RenderStats stats = renderers[i]->get_stats();
+    total.pixels += stats.pixels;
+    total.samples += stats.samples;
+    total.rays += stats.rays;
+  }
+  total.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+  return total;
+}
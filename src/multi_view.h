@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "camera.h"
+#include "hittables/hittable.h"
+#include "renderer.h"
+#include "thread_pool.h"
+
+struct View {
+  Camera camera;
+  // PPM file the view is written to.
+  std::string output;
+};
+
+// Two eyes eye_separation apart along the camera's horizontal axis, both
+// looking at lookat. Left eye first.
+std::vector<CameraSetup> stereo_pair(const CameraSetup& setup,
+                                     double eye_separation);
+// Six 90 degree views from lookfrom, facing +x, -x, +y, -y, +z and -z. Render
+// them with a square image.
+std::vector<CameraSetup> cube_map(const CameraSetup& setup);
+// Views evenly spaced on a circle around lookat and the vup axis, starting
+// at the given placement.
+std::vector<CameraSetup> turntable(const CameraSetup& setup, int count);
+// Builds the views named by "stereo", "cube" or "turntable:<count>". Throws
+// std::invalid_argument for anything else.
+std::vector<CameraSetup> make_view_set(const std::string& spec,
+                                       const CameraSetup& setup);
+// Cameras for the views named by spec, written to <prefix>_<index>.ppm.
+std::vector<View> make_views(const std::string& spec,
+                             const CameraSetup& setup,
+                             double aspect_ratio,
+                             const std::string& prefix);
+
+// Renders every view of the world as a single job on the pool, then writes
+// each to its output. The views share the world and its acceleration
+// structure, and threads move on to the next view's tiles instead of waiting
+// for the last tiles of each view. Returns the statistics of the whole batch.
+RenderStats render_views(ThreadPool& pool,
+                         const RenderSettings& settings,
+                         std::shared_ptr<const Hittable> world,
+                         const std::vector<View>& views);
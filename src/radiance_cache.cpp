@@ -0,0 +1,122 @@
+#include "radiance_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "helpers.h"
+
+namespace {
+
+// Fixed point scale of the sums and the largest sample value they hold.
+const double sum_scale = 65536.0;
+const double max_sample = 1024.0;
+// Cells stop taking samples here. Their average is settled by then, and it
+// keeps the sums from overflowing and hot cells from serializing threads.
+const uint32_t max_count = 1 << 16;
+// Slots searched after the one a key hashes to.
+const size_t max_probes = 8;
+// Buckets per axis for normal directions.
+const int normal_buckets = 4;
+
+int normal_bucket(double n) {
+  const int bucket = static_cast<int>((n + 1) / 2 * normal_buckets);
+  return std::min(std::max(bucket, 0), normal_buckets - 1);
+}
+
+}  // namespace
+
+RadianceCache::RadianceCache(double cs, size_t slot_count)
+    : cell_size{cs}, slot_mask{0}, slots{} {
+  if (cell_size <= 0) {
+    throw std::invalid_argument("Radiance cache cells need a positive size");
+  }
+  size_t size = 1;
+  while (size < slot_count) {
+    size <<= 1;
+  }
+  slot_mask = size - 1;
+  slots.reset(new Slot[size]);
+  for (size_t i = 0; i < size; ++i) {
+    slots[i].key.store(0, std::memory_order_relaxed);
+    for (auto& s : slots[i].sum) {
+      s.store(0, std::memory_order_relaxed);
+    }
+    slots[i].count.store(0, std::memory_order_relaxed);
+  }
+}
+
+void RadianceCache::record(const Point3& point,
+                           const Vec3& normal,
+                           const Color& incoming) {
+  Slot* slot = find_slot(cell_key(point, normal), true);
+  if (!slot || slot->count.load(std::memory_order_relaxed) >= max_count) {
+    return;
+  }
+  const double values[] = {incoming.get_x(), incoming.get_y(),
+                           incoming.get_z()};
+  for (int i = 0; i < 3; ++i) {
+    const double value = clamp(values[i], 0, max_sample);
+    slot->sum[i].fetch_add(static_cast<uint64_t>(value * sum_scale),
+                           std::memory_order_relaxed);
+  }
+  // Readers that see the new count also see the sample's sums.
+  slot->count.fetch_add(1, std::memory_order_release);
+}
+
+bool RadianceCache::lookup(const Point3& point,
+                           const Vec3& normal,
+                           int min_samples,
+                           Color& incoming) const {
+  const Slot* slot = find_slot(cell_key(point, normal), false);
+  if (!slot) {
+    return false;
+  }
+  const uint32_t count = slot->count.load(std::memory_order_acquire);
+  if (count == 0 || count < static_cast<uint32_t>(min_samples)) {
+    return false;
+  }
+  // The sums may already include a few samples the count does not, which
+  // is a small error next to the min_samples they are averaged over.
+  const double scale = 1.0 / (sum_scale * count);
+  incoming = Color{slot->sum[0].load(std::memory_order_relaxed) * scale,
+                   slot->sum[1].load(std::memory_order_relaxed) * scale,
+                   slot->sum[2].load(std::memory_order_relaxed) * scale};
+  return true;
+}
+
+uint64_t RadianceCache::cell_key(const Point3& point,
+                                 const Vec3& normal) const {
+  const int64_t cell[] = {
+      static_cast<int64_t>(std::floor(point.get_x() / cell_size)),
+      static_cast<int64_t>(std::floor(point.get_y() / cell_size)),
+      static_cast<int64_t>(std::floor(point.get_z() / cell_size)),
+      normal_bucket(normal.get_x()) +
+          normal_buckets * (normal_bucket(normal.get_y()) +
+                            normal_buckets * normal_bucket(normal.get_z()))};
+  const uint64_t key = hash_bytes(cell, sizeof(cell));
+  // 0 marks free slots.
+  return key == 0 ? 1 : key;
+}
+
+RadianceCache::Slot* RadianceCache::find_slot(uint64_t key,
+                                              bool insert) const {
+  // Fold in the high bits, which FNV mixes best.
+  const size_t start = static_cast<size_t>(key >> 32 ^ key);
+  for (size_t probe = 0; probe <= max_probes; ++probe) {
+    Slot& slot = slots[(start + probe) & slot_mask];
+    uint64_t found = slot.key.load(std::memory_order_acquire);
+    if (found == key) {
+      return &slot;
+    }
+    if (found == 0) {
+      if (!insert) {
+        return nullptr;
+      }
+      if (slot.key.compare_exchange_strong(found, key,
+                                           std::memory_order_acq_rel) ||
+          found == key) {
+        return &slot;
+      }
+    }
+  }
+  return nullptr;
+}
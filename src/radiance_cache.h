@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "vec3.h"
+
+// Light arriving at diffuse surfaces, averaged over the cells of a hashed
+// spatial grid. A cell is a cube of cell_size world units combined with a
+// coarse direction bucket of the surface normal. Render threads add samples
+// and read averages concurrently without locks.
+//
+// The table has a fixed number of slots. Samples for a cell that finds no
+// free slot near its hash are dropped, so a full cache stops growing instead
+// of evicting.
+class RadianceCache {
+ public:
+  RadianceCache(double cell_size, size_t slot_count = size_t(1) << 18);
+
+  // Adds a sample of the light arriving at point from the hemisphere around
+  // normal.
+  void record(const Point3& point, const Vec3& normal, const Color& incoming);
+  // Sets incoming to the average of the cell and returns true if the cell
+  // has at least min_samples samples.
+  bool lookup(const Point3& point,
+              const Vec3& normal,
+              int min_samples,
+              Color& incoming) const;
+
+ private:
+  struct Slot {
+    // 0 while the slot is free.
+    std::atomic<uint64_t> key;
+    // Sums of the samples in fixed point.
+    std::atomic<uint64_t> sum[3];
+    std::atomic<uint32_t> count;
+  };
+
+  uint64_t cell_key(const Point3& point, const Vec3& normal) const;
+  // Slot holding key, or null. With insert, claims a free slot for it.
+  Slot* find_slot(uint64_t key, bool insert) const;
+
+  double cell_size;
+  size_t slot_mask;
+  std::unique_ptr<Slot[]> slots;
+};
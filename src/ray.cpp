@@ -1,10 +1,10 @@
 #include "ray.h"
 #include "vec3.h"
 
-Ray::Ray() {}
+Ray::Ray() : cone_width{0}, cone_spread{0} {}
 
 Ray::Ray(const Point3 _origin, const Point3 _direction)
-    : origin{_origin}, direction{_direction} {}
+    : origin{_origin}, direction{_direction}, cone_width{0}, cone_spread{0} {}
 
 Point3 Ray::get_origin() const {
   return this->origin;
@@ -16,4 +16,17 @@ Point3 Ray::get_direction() const {
 
 Point3 Ray::at(double t) const {
   return this->origin + t * this->direction;
-}
\ No newline at end of file
+}
+
+void Ray::set_cone(double width, double spread) {
+  cone_width = width;
+  cone_spread = spread;
+}
+
+double Ray::get_cone_spread() const {
+  return cone_spread;
+}
+
+double Ray::footprint(double t) const {
+  return cone_width + t * direction.length() * cone_spread;
+}
@@ -12,7 +12,17 @@ class Ray {
 
   Point3 at(double t) const;
 
+  // The ray stands for a cone of rays, width wide at the origin and growing
+  // by spread per unit of distance, which approximates the area a sample
+  // covers. Both are 0 unless set.
+  void set_cone(double width, double spread);
+  double get_cone_spread() const;
+  // Width of the cone at t.
+  double footprint(double t) const;
+
  private:
   Point3 origin;
   Point3 direction;
+  double cone_width;
+  double cone_spread;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "render_cache.h"
+
+RenderCache::RenderCache(size_t c) : capacity{c} {}
+
+std::shared_ptr<const CachedRender> RenderCache::find(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return find_locked(key);
+}
+
+std::shared_ptr<const CachedRender> RenderCache::wait_find(uint64_t key) {
+  std::unique_lock<std::mutex> lock(mutex);
+  released.wait(lock, [&] { return expected.count(key) == 0; });
+  return find_locked(key);
+}
+
+void RenderCache::insert(uint64_t key,
+                         std::shared_ptr<const CachedRender> render) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (it->first == key) {
+      entries.erase(it);
+      break;
+    }
+  }
+  entries.emplace_front(key, render);
+  if (entries.size() > capacity) {
+    entries.pop_back();
+  }
+}
+
+void RenderCache::expect(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ++expected[key];
+}
+
+void RenderCache::release(uint64_t key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = expected.find(key);
+    if (it == expected.end()) {
+      return;
+    }
+    if (--it->second == 0) {
+      expected.erase(it);
+    }
+  }
+  released.notify_all();
+}
+
+std::shared_ptr<const CachedRender> RenderCache::find_locked(uint64_t key) {
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (it->first == key) {
+      entries.splice(entries.begin(), entries, it);
+      return entries.front().second;
+    }
+  }
+  return nullptr;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "vec3.h"
+
+// Accumulation buffer of a finished render, and the index of the top-level
+// object first hit through each pixel (-1 for the sky).
+struct CachedRender {
+  std::vector<Color> accumulation;
+  std::vector<int> first_hit;
+  // True if some pixels were copied from an ancestor's render instead of
+  // being rendered. Reflections and shadows of the edited objects can be
+  // stale there, so a partial render is reused for its own key but never as
+  // the base of another incremental render, where its errors would add up.
+  bool partial;
+};
+
+// Finished renders keyed by the edit chain hash of their scene, their camera
+// and their settings. Shared by renderers across threads. Holds at most
+// `capacity` renders and evicts the least recently used.
+class RenderCache {
+ public:
+  RenderCache(size_t capacity);
+
+  // Null if there is no render for the key.
+  std::shared_ptr<const CachedRender> find(uint64_t key);
+  // Like find(), but first waits for the expected renders of the key.
+  std::shared_ptr<const CachedRender> wait_find(uint64_t key);
+  void insert(uint64_t key, std::shared_ptr<const CachedRender> render);
+
+  // Notes that a render of the key is on its way, so that wait_find() waits
+  // for it. Each expect() must be followed by a release() once the render is
+  // inserted or has failed.
+  void expect(uint64_t key);
+  void release(uint64_t key);
+
+ private:
+  // Callers hold the mutex.
+  std::shared_ptr<const CachedRender> find_locked(uint64_t key);
+
+  size_t capacity;
+  // Most recently used first.
+  std::list<std::pair<uint64_t, std::shared_ptr<const CachedRender>>> entries;
+  // Number of renders on their way for each key.
+  std::map<uint64_t, int> expected;
+  std::mutex mutex;
+  std::condition_variable released;
+};
@@ -0,0 +1,292 @@
+#include "render_service.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "multi_view.h"
+#include "scenes.h"
+
+RenderService::RenderService(ThreadPool& p,
+                             const RenderSettings& d,
+                             size_t capacity)
+    : pool{p},
+      defaults{d},
+      scene_capacity{capacity},
+      render_cache{2 * capacity},
+      queue_closed{false} {}
+
+void RenderService::serve(std::istream& in, std::ostream& log) {
+  // Each running job holds a framebuffer, so only as many run as keep the
+  // pool busy while some wait for earlier jobs or write their output. Jobs
+  // start in the order they were read, so a job waiting for an earlier one
+  // never holds back the job it waits for.
+  queue_closed = false;
+  std::vector<std::thread> runners;
+  for (int i = 0; i < 2 * pool.size(); ++i) {
+    runners.emplace_back(&RenderService::run_jobs, this, std::ref(log));
+  }
+  int next_id = 1;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    if (line == "quit") {
+      break;
+    }
+
+    try {
+      if (line.compare(0, 5, "edit ") == 0) {
+        edit_scene(line);
+        std::lock_guard<std::mutex> lock(log_mutex);
+        log << "edited: " << line.substr(5) << std::endl;
+        continue;
+      }
+
+      Job job = parse_job(next_id++, line);
+      prepare_job(job);
+      {
+        std::lock_guard<std::mutex> lock(log_mutex);
+        log << "job " << job.id << " queued: " << job.scene_name << " -> "
+            << job.output << std::endl;
+      }
+      {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        queue.push_back(job);
+      }
+      job_queued.notify_one();
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(log_mutex);
+      log << "error: " << e.what() << std::endl;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    queue_closed = true;
+  }
+  job_queued.notify_all();
+  for (auto& runner : runners) {
+    runner.join();
+  }
+}
+
+void RenderService::run_jobs(std::ostream& log) {
+  while (true) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    job_queued.wait(lock, [&] { return queue_closed || !queue.empty(); });
+    if (queue.empty()) {
+      return;
+    }
+    const Job job = queue.front();
+    queue.pop_front();
+    lock.unlock();
+    run_job(job, log);
+  }
+}
+
+RenderService::Job RenderService::parse_job(int id,
+                                            const std::string& line) const {
+  std::istringstream words(line);
+  std::string command;
+  words >> command;
+  if (command != "render") {
+    throw std::invalid_argument("Unknown command: " + command);
+  }
+
+  Job job;
+  job.id = id;
+  job.settings = defaults;
+  job.settings.report_progress = false;
+  bool has_height = false;
+
+  std::string word;
+  while (words >> word) {
+    const size_t equals = word.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Expected key=value: " + word);
+    }
+    const std::string key = word.substr(0, equals);
+    const std::string value = word.substr(equals + 1);
+
+    if (key == "scene") {
+      job.scene_name = value;
+    } else if (key == "out") {
+      job.output = value;
+    } else if (key == "width") {
+      job.settings.image_width = std::stoi(value);
+    } else if (key == "height") {
+      job.settings.image_height = std::stoi(value);
+      has_height = true;
+    } else if (key == "spp") {
+      job.settings.samples_per_pixel = std::stoi(value);
+    } else if (key == "depth") {
+      job.settings.max_depth = std::stoi(value);
+    } else if (key == "sampler") {
+      job.settings.sampler_type = parse_sampler_type(value);
+    } else if (key == "views") {
+      job.views = value;
+    } else {
+      throw std::invalid_argument("Unknown key: " + key);
+    }
+  }
+
+  if (job.scene_name.empty() || job.output.empty()) {
+    throw std::invalid_argument("A job needs scene= and out=");
+  }
+  if (!has_height) {
+    job.settings.image_height =
+        job.views == "cube"
+            ? job.settings.image_width
+            : static_cast<int>(job.settings.image_width / (16.0 / 9.0));
+  }
+  job.settings.validate();
+  return job;
+}
+
+void RenderService::prepare_job(Job& job) {
+  job.scene = get_scene(job.scene_name);
+  if (job.views.empty()) {
+    const double aspect_ratio =
+        static_cast<double>(job.settings.image_width) /
+        job.settings.image_height;
+    job.renderer = std::make_shared<Renderer>(
+        job.settings, job.scene->get_world(),
+        make_scene_camera(job.scene_name, aspect_ratio));
+    job.renderer->expect_cached(render_cache, *job.scene);
+  }
+}
+
+void RenderService::run_job(const Job& job, std::ostream& log) {
+  try {
+    if (!job.views.empty()) {
+      const double aspect_ratio =
+          static_cast<double>(job.settings.image_width) /
+          job.settings.image_height;
+      const RenderStats stats = render_views(
+          pool, job.settings, job.scene->get_world(),
+          make_views(job.views, scene_camera_setup(job.scene_name),
+                     aspect_ratio, job.output));
+      std::lock_guard<std::mutex> lock(log_mutex);
+      log << "job " << job.id << " done in " << stats.seconds << "s, "
+          << stats.rays / stats.seconds << " rays/s, " << stats.pixels
+          << " pixels rendered" << std::endl;
+      return;
+    }
+
+    Renderer& renderer = *job.renderer;
+    renderer.render_cached(pool, render_cache, *job.scene);
+
+    std::ofstream out(job.output);
+    if (!out) {
+      throw std::runtime_error("Cannot open " + job.output);
+    }
+    renderer.write_ppm(out);
+
+    const RenderStats stats = renderer.get_stats();
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log << "job " << job.id << " done in " << stats.seconds << "s, "
+        << stats.rays / stats.seconds << " rays/s, " << stats.pixels
+        << " pixels rendered, " << stats.pixels_reused << " reused"
+        << std::endl;
+  } catch (const std::exception& e) {
+    std::lock_guard<std::mutex> lock(log_mutex);
+    log << "job " << job.id << " failed: " << e.what() << std::endl;
+  }
+}
+
+void RenderService::edit_scene(const std::string& line) {
+  std::istringstream words(line);
+  std::string word;
+  words >> word;
+
+  std::string scene_name;
+  SceneEdit edit;
+  edit.object_id = -1;
+  while (words >> word) {
+    const size_t equals = word.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument("Expected key=value: " + word);
+    }
+    const std::string key = word.substr(0, equals);
+    const std::string text = word.substr(equals + 1);
+
+    if (key == "scene") {
+      scene_name = text;
+    } else if (key == "object") {
+      edit.object_id = std::stoi(text);
+    } else if (key == "move" || key == "albedo") {
+      double x, y, z;
+      char comma1, comma2;
+      std::istringstream numbers(text);
+      if (!(numbers >> x >> comma1 >> y >> comma2 >> z) || comma1 != ',' ||
+          comma2 != ',') {
+        throw std::invalid_argument("Expected x,y,z: " + text);
+      }
+      edit.kind = key;
+      edit.value = Vec3(x, y, z);
+    } else {
+      throw std::invalid_argument("Unknown key: " + key);
+    }
+  }
+
+  if (scene_name.empty() || edit.object_id < 0 || edit.kind.empty()) {
+    throw std::invalid_argument("An edit needs scene=, object= and an edit");
+  }
+  std::shared_ptr<const EditableScene> scene =
+      apply_edit(*get_scene(scene_name), edit);
+
+  std::lock_guard<std::mutex> lock(scenes_mutex);
+  edits[scene_name].push_back(edit);
+  set_scene_locked(scene);
+}
+
+std::shared_ptr<const EditableScene> RenderService::apply_edit(
+    const EditableScene& scene,
+    const SceneEdit& edit) {
+  return edit.kind == "move" ? scene.moved(edit.object_id, edit.value)
+                             : scene.recolored(edit.object_id, edit.value);
+}
+
+std::shared_ptr<const EditableScene> RenderService::get_scene(
+    const std::string& name) {
+  // Scene construction draws from the shared rand() state, so it stays under
+  // the lock.
+  std::lock_guard<std::mutex> lock(scenes_mutex);
+  for (auto it = scenes.begin(); it != scenes.end(); ++it) {
+    if ((*it)->get_name() == name) {
+      scenes.splice(scenes.begin(), scenes, it);
+      return scenes.front();
+    }
+  }
+
+  // Edits hash the same when applied again, so renders cached under the
+  // evicted version are still found.
+  std::shared_ptr<const EditableScene> scene =
+      std::make_shared<const EditableScene>(name);
+  const auto scene_edits = edits.find(name);
+  if (scene_edits != edits.end()) {
+    for (const SceneEdit& edit : scene_edits->second) {
+      scene = apply_edit(*scene, edit);
+    }
+  }
+
+  set_scene_locked(scene);
+  return scene;
+}
+
+void RenderService::set_scene_locked(
+    std::shared_ptr<const EditableScene> scene) {
+  for (auto it = scenes.begin(); it != scenes.end(); ++it) {
+    if ((*it)->get_name() == scene->get_name()) {
+      scenes.erase(it);
+      break;
+    }
+  }
+  scenes.push_front(scene);
+  if (scenes.size() > scene_capacity) {
+    scenes.pop_back();
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "editable_scene.h"
+#include "render_cache.h"
+#include "renderer.h"
+#include "thread_pool.h"
+
+// Local batch render service. Reads jobs from a stream, one per line, and
+// renders them concurrently on a shared pool, which interleaves their tiles
+// fairly. A few jobs per pool thread run at once and the rest wait in a queue,
+// so memory does not grow with the number of jobs read. The most recently used
+// scenes stay in memory between jobs, and so do recent renders: after an edit,
+// a render with the same settings only re-renders the pixels around the edited
+// object, which leaves its distant reflections stale. A job renders the scene
+// as it was when the job was read, and waits for earlier jobs rendering older
+// versions of it so it can build on their result. Edits are kept for good: a
+// scene evicted from memory is built again with all of its edits. A job with
+// views= renders all of its views as one pool job, to <out>_<index>.ppm.
+//
+//   render scene=<name> out=<file.ppm> [width=<n>] [height=<n>] [spp=<n>]
+//          [depth=<n>] [sampler=<name>] [views=<stereo|cube|turntable:n>]
+//   edit scene=<name> object=<id> (move=<x,y,z> | albedo=<r,g,b>)
+//   quit
+class RenderService {
+ public:
+  RenderService(ThreadPool& pool,
+                const RenderSettings& defaults,
+                size_t scene_capacity);
+
+  // Serves jobs until quit or the end of input, then waits for running jobs.
+  void serve(std::istream& in, std::ostream& log);
+
+ private:
+  struct Job {
+    int id;
+    std::string scene_name;
+    std::string output;
+    // Empty for a single view from the scene's camera.
+    std::string views;
+    RenderSettings settings;
+    // Version of the scene current when the job was read, so that edits
+    // read after it do not change what it renders.
+    std::shared_ptr<const EditableScene> scene;
+    // Set up when the job is read for jobs without views, so that renders
+    // of later versions can wait for its cache entry.
+    std::shared_ptr<Renderer> renderer;
+  };
+
+  struct SceneEdit {
+    // "move" or "albedo".
+    std::string kind;
+    int object_id;
+    Vec3 value;
+  };
+
+  // Throws std::invalid_argument for malformed lines and invalid settings.
+  // Does not resolve the scene.
+  Job parse_job(int id, const std::string& line) const;
+  // Takes the current version of the job's scene and, for single views, sets
+  // up its renderer and announces its render to the cache.
+  void prepare_job(Job& job);
+  // Runs queued jobs until the queue is closed and empty.
+  void run_jobs(std::ostream& log);
+  void run_job(const Job& job, std::ostream& log);
+  // Applies an edit line to the current version of its scene.
+  void edit_scene(const std::string& line);
+  // Builds the scene again from its edits if it was evicted.
+  std::shared_ptr<const EditableScene> get_scene(const std::string& name);
+  static std::shared_ptr<const EditableScene> apply_edit(
+      const EditableScene& scene,
+      const SceneEdit& edit);
+  // Makes scene the current, most recently used version of its name. Needs
+  // scenes_mutex held.
+  void set_scene_locked(std::shared_ptr<const EditableScene> scene);
+
+  ThreadPool& pool;
+  RenderSettings defaults;
+  size_t scene_capacity;
+
+  // Current version of the most recently used scenes, first to last.
+  std::list<std::shared_ptr<const EditableScene>> scenes;
+  // Every edit made to each scene, in order. Unlike the scenes these are
+  // never evicted, since they cannot be rebuilt from anything else.
+  std::map<std::string, std::vector<SceneEdit>> edits;
+  RenderCache render_cache;
+  // Jobs read but not yet started, oldest first.
+  std::deque<Job> queue;
+  bool queue_closed;
+  std::mutex queue_mutex;
+  std::condition_variable job_queued;
+  std::mutex scenes_mutex;
+  std::mutex log_mutex;
+};
@@ -0,0 +1,662 @@
+#include "renderer.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include "band_writer.h"
+#include "color.h"
+#include "helpers.h"
+
+namespace {
+
+// Spread of the ray cone after a diffuse bounce, in radians. Diffuse
+// reflection blurs whatever it sees, so the wide cone makes textures seen
+// through it read coarse mip levels.
+const double diffuse_spread = 0.3;
+
+// How often the preview status is updated while a pass renders.
+const std::chrono::milliseconds preview_interval{100};
+
+// Grows the marked region of a width by height mask by radius pixels.
+void dilate(std::vector<char>& mask, int width, int height, int radius) {
+  std::vector<char> out(mask.size());
+  std::vector<int> prefix(std::max(width, height) + 1);
+
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      prefix[col + 1] = prefix[col] + mask[row * width + col];
+    }
+    for (int col = 0; col < width; ++col) {
+      const int lo = std::max(col - radius, 0);
+      const int hi = std::min(col + radius + 1, width);
+      out[row * width + col] = prefix[hi] - prefix[lo] > 0;
+    }
+  }
+  for (int col = 0; col < width; ++col) {
+    for (int row = 0; row < height; ++row) {
+      prefix[row + 1] = prefix[row] + out[row * width + col];
+    }
+    for (int row = 0; row < height; ++row) {
+      const int lo = std::max(row - radius, 0);
+      const int hi = std::min(row + radius + 1, height);
+      mask[row * width + col] = prefix[hi] - prefix[lo] > 0;
+    }
+  }
+}
+
+}  // namespace
+
+RenderSettings::RenderSettings()
+    : image_width{1200},
+      image_height{675},
+      samples_per_pixel{256},
+      max_depth{30},
+      sampler_type{SamplerType::sobol},
+      seed{0},
+      tile_size{16},
+      report_progress{false},
+      incremental_margin{0.05},
+      radiance_cache{false},
+      radiance_cache_cell_size{0.05},
+      radiance_cache_samples{64},
+      radiance_cache_depth{1},
+      environment{} {}
+
+void RenderSettings::validate() const {
+  // Pixel positions are divided by the width and height less one.
+  if (image_width < 2 || image_height < 2) {
+    throw std::invalid_argument("The image must be at least 2x2 pixels, not " +
+                                std::to_string(image_width) + "x" +
+                                std::to_string(image_height));
+  }
+  if (samples_per_pixel < 1) {
+    throw std::invalid_argument("Need at least one sample per pixel");
+  }
+  if (max_depth < 1) {
+    throw std::invalid_argument("The ray depth must be at least 1");
+  }
+}
+
+Renderer::Renderer(const RenderSettings& s,
+                   std::shared_ptr<const Hittable> w,
+                   const Camera& c)
+    : settings{s},
+      world{w},
+      camera{c},
+      pixel_spread{c.pixel_spread(s.image_height)},
+      has_lights{w->emitted_power() > 0},
+      radiance_cache{},
+      preview{},
+      pixels{nullptr},
+      pixels_done{0},
+      pixels_reused{0},
+      samples_done{0},
+      rays_traced{0},
+      seconds{0},
+      cache_expected{false} {
+  if (settings.radiance_cache) {
+    radiance_cache.reset(new RadianceCache(settings.radiance_cache_cell_size));
+  }
+}
+
+const RenderSettings& Renderer::get_settings() const {
+  return settings;
+}
+
+RenderStats Renderer::get_stats() const {
+  return RenderStats{pixels_done, pixels_reused, samples_done, rays_traced,
+                     seconds};
+}
+
+const Color* Renderer::get_framebuffer() const {
+  return pixels;
+}
+
+const std::vector<int>& Renderer::get_first_hits() const {
+  return first_hits;
+}
+
+std::shared_ptr<RadianceCache> Renderer::get_radiance_cache() const {
+  return radiance_cache;
+}
+
+void Renderer::set_radiance_cache(std::shared_ptr<RadianceCache> cache) {
+  radiance_cache = cache;
+}
+
+void Renderer::set_preview(std::shared_ptr<SharedPreview> p) {
+  if (p->get_width() != settings.image_width ||
+      p->get_height() != settings.image_height ||
+      p->get_tile_size() != settings.tile_size) {
+    throw std::invalid_argument("The preview does not match the settings");
+  }
+  preview = p;
+  pixels = nullptr;
+  framebuffer.clear();
+}
+
+Color Renderer::ray_color(const Ray& r,
+                          Sampler& sampler,
+                          int depth,
+                          long long& rays,
+                          double bsdf_pdf,
+                          int* object_id) const {
+  if (object_id) {
+    *object_id = -1;
+  }
+  if (depth > settings.max_depth) {
+    return Color{0, 0, 0};
+  }
+  ++rays;
+
+  HitRecord record;
+  if (!world->hit(r, 0.001, infinity, record)) {
+    return sky(r, bsdf_pdf);
+  }
+  if (object_id) {
+    *object_id = record.object_id;
+  }
+
+  Ray scattered;
+  Color attenuation;
+  const bool scatters = record.material->scatter(r, record, attenuation,
+                                                 scattered, sampler);
+  Color direct = emitted(r, record, bsdf_pdf);
+  if (has_lights) {
+    direct += sample_lights(r, record, sampler, rays);
+  }
+  if (settings.environment) {
+    direct += sample_environment(r, record, sampler, rays);
+  }
+  if (!scatters) {
+    return direct;
+  }
+  scattered.set_cone(r.footprint(record.t),
+                     record.material->is_diffuse() ? diffuse_spread
+                                                   : r.get_cone_spread());
+  double scattered_pdf = 0;
+  if (has_lights || settings.environment) {
+    record.material->eval(r, record, scattered.get_direction(),
+                          scattered_pdf);
+  }
+  if (!radiance_cache || !record.material->is_diffuse()) {
+    return direct + attenuation * ray_color(scattered, sampler, depth + 1,
+                                            rays, scattered_pdf);
+  }
+
+  Color incoming;
+  if (depth >= settings.radiance_cache_depth &&
+      radiance_cache->lookup(record.point, record.normal,
+                             settings.radiance_cache_samples, incoming)) {
+    return direct + attenuation * incoming;
+  }
+  incoming = ray_color(scattered, sampler, depth + 1, rays, scattered_pdf);
+  radiance_cache->record(record.point, record.normal, incoming);
+  return direct + attenuation * incoming;
+}
+
+Color Renderer::sky(const Ray& r, double bsdf_pdf) const {
+  if (!settings.environment) {
+    Vec3 unit_direction = normalize(r.get_direction());
+    const double t = map(unit_direction.get_y(), -1, 1, 0, 1);
+    return lerp_color(Color{1.0, 1.0, 1.0}, Color{0.5, 0.7, 1.0}, t);
+  }
+
+  const Color radiance = settings.environment->radiance(r.get_direction());
+  if (bsdf_pdf <= 0) {
+    return radiance;
+  }
+  // The direction could also have come from sample_environment(). Weigh
+  // the two with the power heuristic.
+  const double light_pdf = settings.environment->pdf(r.get_direction());
+  return radiance * (bsdf_pdf * bsdf_pdf /
+                     (bsdf_pdf * bsdf_pdf + light_pdf * light_pdf));
+}
+
+Color Renderer::emitted(const Ray& r,
+                        const HitRecord& record,
+                        double bsdf_pdf) const {
+  if (!record.front_face) {
+    return Color{0, 0, 0};
+  }
+  const Color radiance = record.material->emitted();
+  if (bsdf_pdf <= 0 || (radiance.get_x() == 0 && radiance.get_y() == 0 &&
+                        radiance.get_z() == 0)) {
+    return radiance;
+  }
+  // sample_lights() at the previous hit could have picked this direction too.
+  const double light_pdf =
+      world->light_pdf(r.get_origin(), r.get_direction(), record.object_id);
+  return radiance * (bsdf_pdf * bsdf_pdf /
+                     (bsdf_pdf * bsdf_pdf + light_pdf * light_pdf));
+}
+
+Color Renderer::sample_lights(const Ray& r,
+                              const HitRecord& record,
+                              Sampler& sampler,
+                              long long& rays) const {
+  const double u = sampler.get_1d();
+  const Point2 jitter = sampler.get_2d();
+  LightSample light;
+  if (!world->sample_light(record.point, u, jitter, light) ||
+      light.pdf <= 0) {
+    return Color{0, 0, 0};
+  }
+  double bsdf_pdf;
+  const Color f = record.material->eval(r, record, light.direction, bsdf_pdf);
+  if (bsdf_pdf <= 0) {
+    return Color{0, 0, 0};
+  }
+
+  // Stop short of the light itself, so that only blockers count.
+  ++rays;
+  if (world->hit_any(Ray(record.point, light.direction), 0.001,
+                     light.distance * (1 - 1e-6))) {
+    return Color{0, 0, 0};
+  }
+  const double weight =
+      light.pdf * light.pdf / (light.pdf * light.pdf + bsdf_pdf * bsdf_pdf);
+  return f * light.radiance * (weight / light.pdf);
+}
+
+Color Renderer::sample_environment(const Ray& r,
+                                   const HitRecord& record,
+                                   Sampler& sampler,
+                                   long long& rays) const {
+  const double u = sampler.get_1d();
+  const Point2 jitter = sampler.get_2d();
+  double light_pdf;
+  const Vec3 direction = settings.environment->sample(u, jitter, light_pdf);
+  double bsdf_pdf;
+  const Color f = record.material->eval(r, record, direction, bsdf_pdf);
+  if (light_pdf <= 0 || bsdf_pdf <= 0) {
+    return Color{0, 0, 0};
+  }
+
+  ++rays;
+  if (world->hit_any(Ray(record.point, direction), 0.001, infinity)) {
+    return Color{0, 0, 0};
+  }
+  const double weight =
+      light_pdf * light_pdf / (light_pdf * light_pdf + bsdf_pdf * bsdf_pdf);
+  return f * settings.environment->radiance(direction) * (weight / light_pdf);
+}
+
+Color Renderer::compute_pixel(int row,
+                              int col,
+                              int first_sample,
+                              int sample_count,
+                              Sampler& sampler,
+                              long long& rays,
+                              int* first_hit) const {
+  Color pixel_color = Color{0, 0, 0};
+
+  // Sample the pixel's footprint, one pixel wide and centered on the pixel.
+  for (int i = first_sample; i < first_sample + sample_count; ++i) {
+    sampler.start_sample(col, row, i);
+    const Point2 jitter = sampler.get_2d();
+    auto col_fraction = (col + jitter.u - 0.5) / (settings.image_width - 1);
+    auto row_fraction = (row + jitter.v - 0.5) / (settings.image_height - 1);
+
+    Ray ray = camera.get_ray(col_fraction, row_fraction, sampler);
+    ray.set_cone(0, pixel_spread);
+    pixel_color +=
+        ray_color(ray, sampler, 0, rays, 0, i == 0 ? first_hit : nullptr);
+  }
+
+  return pixel_color;
+}
+
+void Renderer::add_progress(long long pixels,
+                            long long samples,
+                            long long rays) {
+  const long long total =
+      static_cast<long long>(settings.image_width) * settings.image_height;
+  const long long before = pixels_done.fetch_add(pixels);
+  samples_done += samples;
+  rays_traced += rays;
+
+  // Report every 5%.
+  if (settings.report_progress &&
+      (before + pixels) * 20 / total != before * 20 / total) {
+    std::cerr << "Progress: " << (double)(before + pixels) / total * 100
+              << std::endl;
+  }
+}
+
+void Renderer::clear_framebuffer() {
+  const int size = settings.image_width * settings.image_height;
+  if (preview) {
+    pixels = preview->get_pixels();
+    std::fill(pixels, pixels + size, Color{0, 0, 0});
+    preview->set_all_tile_samples(0);
+  } else {
+    framebuffer.assign(size, Color{0, 0, 0});
+    pixels = framebuffer.data();
+  }
+  first_hits.assign(size, -1);
+}
+
+void Renderer::publish_preview(bool rendering,
+                               int first_sample,
+                               int sample_count,
+                               double pass_seconds) {
+  if (preview) {
+    preview->publish(PreviewStatus{rendering, settings.samples_per_pixel,
+                                   first_sample, sample_count, pixels_done,
+                                   rays_traced, seconds + pass_seconds});
+  }
+}
+
+void Renderer::render(ThreadPool& pool) {
+  const auto start = std::chrono::steady_clock::now();
+  render_tiles(pool, 0, settings.samples_per_pixel, nullptr, nullptr);
+  seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+  publish_preview(false, 0, settings.samples_per_pixel);
+}
+
+void Renderer::render_pass(ThreadPool& pool,
+                           int first_sample,
+                           int sample_count) {
+  const auto start = std::chrono::steady_clock::now();
+  render_tiles(pool, first_sample, sample_count, nullptr, nullptr);
+  seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+  publish_preview(false, first_sample, sample_count);
+}
+
+void Renderer::render_cached(ThreadPool& pool,
+                             RenderCache& cache,
+                             const EditableScene& scene) {
+  if (scene.get_world() != world) {
+    throw std::invalid_argument(
+        "render_cached needs the scene the renderer was built with");
+  }
+  const auto start = std::chrono::steady_clock::now();
+  const uint64_t key = cache_key(scene.get_edit_chain_hash());
+
+  try {
+    std::shared_ptr<const CachedRender> cached = cache.find(key);
+    if (cached) {
+      clear_framebuffer();
+      std::copy(cached->accumulation.begin(), cached->accumulation.end(),
+                pixels);
+      first_hits = cached->first_hit;
+      pixels_reused += cached->accumulation.size();
+      if (preview) {
+        preview->set_all_tile_samples(settings.samples_per_pixel);
+      }
+    } else {
+      std::shared_ptr<const CachedRender> previous;
+      std::vector<char> dirty;
+      for (const SceneAncestor& ancestor : scene.get_ancestors()) {
+        previous = cache.wait_find(cache_key(ancestor.edit_chain_hash));
+        if (previous && !previous->partial) {
+          dirty = find_dirty_pixels(*previous, ancestor.changes);
+          break;
+        }
+        previous.reset();
+      }
+      render_tiles(pool, 0, settings.samples_per_pixel,
+                   previous ? &dirty : nullptr, previous.get());
+      const std::vector<Color> accumulation(
+          pixels, pixels + settings.image_width * settings.image_height);
+      const bool partial =
+          previous && std::find(dirty.begin(), dirty.end(), 0) != dirty.end();
+      cache.insert(key, std::make_shared<CachedRender>(
+                            CachedRender{accumulation, first_hits, partial}));
+    }
+  } catch (...) {
+    if (cache_expected) {
+      cache_expected = false;
+      cache.release(key);
+    }
+    throw;
+  }
+  if (cache_expected) {
+    cache_expected = false;
+    cache.release(key);
+  }
+
+  seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+  publish_preview(false, 0, settings.samples_per_pixel);
+}
+
+void Renderer::expect_cached(RenderCache& cache, const EditableScene& scene) {
+  cache.expect(cache_key(scene.get_edit_chain_hash()));
+  cache_expected = true;
+}
+
+void Renderer::add_render_tasks(std::vector<std::function<void()>>& tasks) {
+  add_tile_tasks(0, settings.samples_per_pixel, nullptr, nullptr, tasks);
+}
+
+void Renderer::render_tiles(ThreadPool& pool,
+                            int first_sample,
+                            int sample_count,
+                            const std::vector<char>* dirty,
+                            const CachedRender* previous) {
+  std::vector<std::function<void()>> tasks;
+  add_tile_tasks(first_sample, sample_count, dirty, previous, tasks);
+  publish_preview(true, first_sample, sample_count);
+  if (!preview) {
+    pool.run(tasks);
+  } else {
+    // The pool blocks this thread until the pass is done, which can be the
+    // whole render, so another thread keeps the status current meanwhile.
+    const auto start = std::chrono::steady_clock::now();
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    std::thread publisher([&] {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!finished.wait_for(lock, preview_interval, [&] { return done; })) {
+        publish_preview(true, first_sample, sample_count,
+                        std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+      }
+    });
+    const auto stop_publisher = [&] {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+      }
+      finished.notify_one();
+      publisher.join();
+    };
+    try {
+      pool.run(tasks);
+    } catch (...) {
+      stop_publisher();
+      throw;
+    }
+    stop_publisher();
+  }
+
+  if (dirty) {
+    long long reused = 0;
+    for (char d : *dirty) {
+      reused += d ? 0 : 1;
+    }
+    pixels_reused += reused;
+  }
+}
+
+void Renderer::add_tile_tasks(int first_sample,
+                              int sample_count,
+                              const std::vector<char>* dirty,
+                              const CachedRender* previous,
+                              std::vector<std::function<void()>>& tasks) {
+  const int width = settings.image_width;
+  const int height = settings.image_height;
+  const int tile = settings.tile_size;
+  if (first_sample == 0) {
+    clear_framebuffer();
+  }
+
+  for (int row0 = 0; row0 < height; row0 += tile) {
+    for (int col0 = 0; col0 < width; col0 += tile) {
+      tasks.push_back([this, row0, col0, tile, width, height, first_sample,
+                       sample_count, dirty, previous] {
+        std::unique_ptr<Sampler> sampler =
+            make_sampler(settings.sampler_type, settings.samples_per_pixel,
+                         settings.seed);
+        const int row1 = std::min(row0 + tile, height);
+        const int col1 = std::min(col0 + tile, width);
+        long long rays = 0;
+        long long rendered = 0;
+        for (int row = row0; row < row1; ++row) {
+          for (int col = col0; col < col1; ++col) {
+            const int i = row * width + col;
+            if (dirty && !(*dirty)[i]) {
+              pixels[i] = previous->accumulation[i];
+              first_hits[i] = previous->first_hit[i];
+              continue;
+            }
+            pixels[i] += compute_pixel(row, col, first_sample, sample_count,
+                                       *sampler, rays, &first_hits[i]);
+            ++rendered;
+          }
+        }
+        if (preview) {
+          preview->set_tile_samples(row0 / tile, col0 / tile,
+                                    first_sample + sample_count);
+        }
+        add_progress(rendered, rendered * sample_count, rays);
+      });
+    }
+  }
+}
+
+std::vector<char> Renderer::find_dirty_pixels(
+    const CachedRender& previous,
+    const std::vector<SceneChange>& changes) const {
+  const int width = settings.image_width;
+  const int height = settings.image_height;
+  std::vector<char> dirty(width * height, 0);
+  std::set<int> changed_ids;
+
+  for (const SceneChange& change : changes) {
+    if (change.emitter) {
+      return std::vector<char>(width * height, 1);
+    }
+    changed_ids.insert(change.object_id);
+    for (const Aabb* box : {&change.old_box, &change.new_box}) {
+      double s0, s1, t0, t1;
+      if (!camera.screen_bounds(box->get_min(), box->get_max(), s0, s1, t0,
+                                t1)) {
+        return std::vector<char>(width * height, 1);
+      }
+      // Invert the pixel jitter in compute_pixel to find the pixels whose
+      // samples can land in [s0, s1] x [t0, t1].
+      const int col0 = std::max(0, (int)floor(s0 * (width - 1) - 0.5));
+      const int col1 = std::min(width - 1, (int)ceil(s1 * (width - 1) + 0.5));
+      const int row0 = std::max(0, (int)floor(t0 * (height - 1) - 0.5));
+      const int row1 =
+          std::min(height - 1, (int)ceil(t1 * (height - 1) + 0.5));
+      for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+          dirty[row * width + col] = 1;
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < dirty.size(); ++i) {
+    if (changed_ids.count(previous.first_hit[i])) {
+      dirty[i] = 1;
+    }
+  }
+
+  dilate(dirty, width, height,
+         static_cast<int>(
+             ceil(settings.incremental_margin * std::max(width, height))));
+  return dirty;
+}
+
+uint64_t Renderer::cache_key(uint64_t edit_chain_hash) const {
+  const int values[] = {settings.image_width,
+                        settings.image_height,
+                        settings.samples_per_pixel,
+                        settings.max_depth,
+                        static_cast<int>(settings.sampler_type),
+                        static_cast<int>(settings.seed),
+                        settings.radiance_cache,
+                        settings.radiance_cache_samples,
+                        settings.radiance_cache_depth};
+  uint64_t key = hash_bytes(&edit_chain_hash, sizeof(edit_chain_hash));
+  key = hash_bytes(&settings.radiance_cache_cell_size,
+                   sizeof(settings.radiance_cache_cell_size), key);
+  const uint64_t environment_hash =
+      settings.environment ? settings.environment->hash() : 0;
+  key = hash_bytes(&environment_hash, sizeof(environment_hash), key);
+  const uint64_t camera_hash = camera.hash();
+  key = hash_bytes(&camera_hash, sizeof(camera_hash), key);
+  return hash_bytes(values, sizeof(values), key);
+}
+
+void Renderer::render_streaming(ThreadPool& pool, std::ostream& out) {
+  const auto start = std::chrono::steady_clock::now();
+  const int width = settings.image_width;
+
+  // Bands of tile_size rows with two in flight per thread keep every thread
+  // busy while the encoder catches up.
+  BandWriter writer(out, width, settings.image_height, settings.tile_size,
+                    2 * pool.size(), settings.samples_per_pixel);
+
+  std::vector<std::function<void()>> tasks;
+  for (int band = 0; band < writer.band_count(); ++band) {
+    tasks.push_back([this, band, width, &writer] {
+      std::unique_ptr<Sampler> sampler =
+          make_sampler(settings.sampler_type, settings.samples_per_pixel,
+                         settings.seed);
+      Color* pixels = writer.acquire_band(band);
+      long long rays = 0;
+      for (int row = writer.first_row(band); row >= writer.last_row(band);
+           --row) {
+        Color* line = pixels + (writer.first_row(band) - row) * width;
+        for (int col = 0; col < width; ++col) {
+          line[col] = compute_pixel(row, col, 0, settings.samples_per_pixel,
+                                    *sampler, rays, nullptr);
+        }
+      }
+      writer.complete_band(band);
+      const long long pixels_in_band =
+          (writer.first_row(band) - writer.last_row(band) + 1) * width;
+      add_progress(pixels_in_band,
+                   pixels_in_band * settings.samples_per_pixel, rays);
+    });
+  }
+  pool.run(tasks);
+  writer.finish();
+
+  seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                           start)
+                 .count();
+}
+
+void Renderer::write_ppm(std::ostream& out) const {
+  const int width = settings.image_width;
+  out << "P3" << std::endl;
+  out << width << " " << settings.image_height << std::endl;
+  out << 255 << std::endl;
+
+  for (int row = settings.image_height - 1; row >= 0; --row) {
+    for (int col = 0; col < width; ++col) {
+      write_color(out, pixels[row * width + col],
+                  settings.samples_per_pixel);
+    }
+    out << '\n';
+  }
+  out.flush();
+}
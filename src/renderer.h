@@ -0,0 +1,207 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "camera.h"
+#include "editable_scene.h"
+#include "environment.h"
+#include "hittables/hittable.h"
+#include "radiance_cache.h"
+#include "render_cache.h"
+#include "samplers/sampler.h"
+#include "shared_preview.h"
+#include "thread_pool.h"
+
+struct RenderSettings {
+  RenderSettings();
+
+  // Throws std::invalid_argument unless the image is at least 2x2 pixels and
+  // the sample count and depth are positive.
+  void validate() const;
+
+  int image_width;
+  int image_height;
+  int samples_per_pixel;
+  int max_depth;
+  SamplerType sampler_type;
+  // Renders with different seeds have independent noise.
+  uint32_t seed;
+  // Edge length in pixels of the square tiles handed to the pool.
+  int tile_size;
+  // Print progress to stderr while rendering.
+  bool report_progress;
+  // Margin around the region an edit touches that is re-rendered too, to
+  // catch nearby indirect effects such as shadows and color bleeding, as a
+  // fraction of the larger image side so that it covers the same part of the
+  // scene at every resolution. Effects that land farther away, such as
+  // reflections in distant mirrors and long shadows, are left stale.
+  double incremental_margin;
+  // Diffuse bounces at depth radiance_cache_depth or deeper take the light
+  // arriving at them from a radiance cache once its cell has
+  // radiance_cache_samples samples, instead of tracing on. The cache fills
+  // from every diffuse hit as the image renders. Larger cells, fewer samples
+  // and a smaller depth cut more paths short at the cost of more bias, and
+  // make the result depend on thread timing.
+  bool radiance_cache;
+  double radiance_cache_cell_size;
+  int radiance_cache_samples;
+  int radiance_cache_depth;
+  // Light from the sky. Null for the default white to blue gradient. With a
+  // map, diffuse and rough metal hits also sample the map directly and weigh
+  // both strategies with multiple importance sampling.
+  std::shared_ptr<const Environment> environment;
+};
+
+struct RenderStats {
+  long long pixels;
+  // Pixels copied from a cached render instead of being rendered.
+  long long pixels_reused;
+  long long samples;
+  long long rays;
+  double seconds;
+};
+
+// Renders one image of a shared world. A Renderer owns its settings,
+// framebuffer and statistics, so any number of them can run at once on the
+// same ThreadPool.
+class Renderer {
+ public:
+  Renderer(const RenderSettings& settings,
+           std::shared_ptr<const Hittable> world,
+           const Camera& camera);
+
+  const RenderSettings& get_settings() const;
+  RenderStats get_stats() const;
+  // Sum of the samples of each of the image_width * image_height pixels, row
+  // major with row 0 at the bottom. Null before the first render.
+  const Color* get_framebuffer() const;
+  // Index of the top-level object first hit through each pixel, -1 for sky.
+  const std::vector<int>& get_first_hits() const;
+  // Null unless settings.radiance_cache is set.
+  std::shared_ptr<RadianceCache> get_radiance_cache() const;
+  // Shares a radiance cache with other renderers of the same world.
+  void set_radiance_cache(std::shared_ptr<RadianceCache> cache);
+  // Renders into the preview's framebuffer from now on and keeps its tile
+  // counts and status current. Throws std::invalid_argument if its size or
+  // tiles differ from the settings.
+  void set_preview(std::shared_ptr<SharedPreview> preview);
+
+  // Renders the frame in tiles on the pool. Blocks until it is done.
+  void render(ThreadPool& pool);
+  // Clears the framebuffer and appends the tasks that render it, so several
+  // renderers can share one pool job. Once the tasks have run the framebuffer
+  // holds the image. Time spent is not added to the statistics.
+  void add_render_tasks(std::vector<std::function<void()>>& tasks);
+  // Adds samples [first_sample, first_sample + sample_count) to every pixel,
+  // for progressive rendering. A pass starting at sample 0 clears the
+  // framebuffer first. Samplers are set up for samples_per_pixel samples, so
+  // going past it loses stratification.
+  void render_pass(ThreadPool& pool, int first_sample, int sample_count);
+  // Renders a version of an editable scene, whose world must be the one this
+  // renderer was built with. If the cache holds a render of this version it
+  // is reused. If it holds a full render of a recent ancestor, only the
+  // pixels the edits since then can affect are re-rendered: those covered by
+  // the changed objects' old and new bounds, those that saw a changed object,
+  // and a margin around them. Reflections of a changed object outside that
+  // region are not updated. The result is added to the cache.
+  void render_cached(ThreadPool& pool,
+                     RenderCache& cache,
+                     const EditableScene& scene);
+  // Tells the cache that render_cached() of the scene will follow, so that
+  // renders of its later versions wait for this one and build on it instead
+  // of starting from scratch. Call it in the order the versions were made.
+  void expect_cached(RenderCache& cache, const EditableScene& scene);
+  // Renders bands from the top of the image down and streams them to out as
+  // a PPM, holding only a few bands in memory. The framebuffer is not kept.
+  void render_streaming(ThreadPool& pool, std::ostream& out);
+  // Writes the framebuffer as a PPM.
+  void write_ppm(std::ostream& out) const;
+
+ private:
+  // Adds the given samples to the pixels marked in dirty, or to all of them
+  // if dirty is null, and copies the rest from previous.
+  void render_tiles(ThreadPool& pool,
+                    int first_sample,
+                    int sample_count,
+                    const std::vector<char>* dirty,
+                    const CachedRender* previous);
+  void add_tile_tasks(int first_sample,
+                      int sample_count,
+                      const std::vector<char>* dirty,
+                      const CachedRender* previous,
+                      std::vector<std::function<void()>>& tasks);
+  std::vector<char> find_dirty_pixels(
+      const CachedRender& previous,
+      const std::vector<SceneChange>& changes) const;
+  uint64_t cache_key(uint64_t edit_chain_hash) const;
+
+  // Sum of samples [first_sample, first_sample + sample_count) of a pixel.
+  // Unless first_hit is null, it is set when the range starts at sample 0.
+  Color compute_pixel(int row,
+                      int col,
+                      int first_sample,
+                      int sample_count,
+                      Sampler& sampler,
+                      long long& rays,
+                      int* first_hit) const;
+  // bsdf_pdf is the density with which the bounce that produced r picked
+  // its direction, or 0 for camera rays and mirror-like bounces. Unless
+  // object_id is null, it is set to the object_id r hits, or -1.
+  Color ray_color(const Ray& r,
+                  Sampler& sampler,
+                  int depth,
+                  long long& rays,
+                  double bsdf_pdf,
+                  int* object_id = nullptr) const;
+  // Light seen by a ray that leaves the scene.
+  Color sky(const Ray& r, double bsdf_pdf) const;
+  // Light emitted by the surface hit, weighed against next-event estimation
+  // at the previous hit when a bounce found it.
+  Color emitted(const Ray& r, const HitRecord& record, double bsdf_pdf) const;
+  // Light from an emitting object reaching the hit directly, through a
+  // shadow ray to a point picked on a light.
+  Color sample_lights(const Ray& r,
+                      const HitRecord& record,
+                      Sampler& sampler,
+                      long long& rays) const;
+  // Light from the environment map reaching the hit directly, through a
+  // direction sampled from the map.
+  Color sample_environment(const Ray& r,
+                           const HitRecord& record,
+                           Sampler& sampler,
+                           long long& rays) const;
+  void add_progress(long long pixels, long long samples, long long rays);
+  // Zeroes the framebuffer and first hits for a new render.
+  void clear_framebuffer();
+  // pass_seconds is the time spent so far in a pass that is rendering.
+  void publish_preview(bool rendering,
+                       int first_sample,
+                       int sample_count,
+                       double pass_seconds = 0);
+
+  RenderSettings settings;
+  std::shared_ptr<const Hittable> world;
+  Camera camera;
+  double pixel_spread;
+  // Whether the world has emitting objects to sample at each hit.
+  bool has_lights;
+  std::shared_ptr<RadianceCache> radiance_cache;
+  std::shared_ptr<SharedPreview> preview;
+  // Storage for the framebuffer when there is no preview.
+  std::vector<Color> framebuffer;
+  Color* pixels;
+  std::vector<int> first_hits;
+
+  std::atomic<long long> pixels_done;
+  long long pixels_reused;
+  std::atomic<long long> samples_done;
+  std::atomic<long long> rays_traced;
+  double seconds;
+  // Whether expect_cached() was called and render_cached() has yet to
+  // release the expectation.
+  bool cache_expected;
+};
@@ -0,0 +1,153 @@
+#include "blue_noise_sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "sobol_sampler.h"
+
+namespace {
+
+const int mask_size = 64;
+const int mask_pixels = mask_size * mask_size;
+
+int argmax(const std::vector<double>& energy,
+           const std::vector<bool>& pattern,
+           bool value) {
+  int best = -1;
+  for (int i = 0; i < mask_pixels; ++i) {
+    if (pattern[i] == value && (best < 0 || energy[i] > energy[best])) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+int argmin(const std::vector<double>& energy,
+           const std::vector<bool>& pattern,
+           bool value) {
+  int best = -1;
+  for (int i = 0; i < mask_pixels; ++i) {
+    if (pattern[i] == value && (best < 0 || energy[i] < energy[best])) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+// Builds a tileable blue noise mask with the void-and-cluster method
+// (Ulichney 1993). Each pixel's rank is scaled to [0, 1).
+std::vector<double> make_blue_noise_mask() {
+  // Gaussian filter weights indexed by toroidal offset.
+  const double sigma = 1.5;
+  std::vector<double> weight(mask_pixels);
+  for (int dy = 0; dy < mask_size; ++dy) {
+    for (int dx = 0; dx < mask_size; ++dx) {
+      const int wx = std::min(dx, mask_size - dx);
+      const int wy = std::min(dy, mask_size - dy);
+      weight[dy * mask_size + dx] =
+          exp(-(wx * wx + wy * wy) / (2 * sigma * sigma));
+    }
+  }
+
+  std::vector<double> energy(mask_pixels, 0.0);
+  std::vector<bool> pattern(mask_pixels, false);
+  auto toggle = [&](int p, bool on) {
+    pattern[p] = on;
+    const int px = p % mask_size, py = p / mask_size;
+    const double sign = on ? 1.0 : -1.0;
+    for (int y = 0; y < mask_size; ++y) {
+      const int dy = (y - py + mask_size) % mask_size;
+      for (int x = 0; x < mask_size; ++x) {
+        const int dx = (x - px + mask_size) % mask_size;
+        energy[y * mask_size + x] += sign * weight[dy * mask_size + dx];
+      }
+    }
+  };
+
+  // Initial pattern: a tenth of the pixels, picked by hash, then relaxed by
+  // moving the tightest cluster into the largest void until it is stable.
+  const int initial_ones = mask_pixels / 10;
+  for (int placed = 0, i = 0; placed < initial_ones; ++i) {
+    const int p = hash_u32(i) % mask_pixels;
+    if (!pattern[p]) {
+      toggle(p, true);
+      ++placed;
+    }
+  }
+  for (int iteration = 0; iteration < mask_pixels; ++iteration) {
+    const int cluster = argmax(energy, pattern, true);
+    toggle(cluster, false);
+    const int void_pixel = argmin(energy, pattern, false);
+    toggle(void_pixel, true);
+    if (void_pixel == cluster) {
+      break;
+    }
+  }
+
+  std::vector<int> rank(mask_pixels, 0);
+  const std::vector<bool> initial_pattern = pattern;
+  const std::vector<double> initial_energy = energy;
+
+  // Rank the initial points by repeatedly removing the tightest cluster.
+  for (int r = initial_ones - 1; r >= 0; --r) {
+    const int cluster = argmax(energy, pattern, true);
+    toggle(cluster, false);
+    rank[cluster] = r;
+  }
+
+  // Rank the remaining pixels by repeatedly filling the largest void.
+  pattern = initial_pattern;
+  energy = initial_energy;
+  for (int r = initial_ones; r < mask_pixels; ++r) {
+    const int void_pixel = argmin(energy, pattern, false);
+    toggle(void_pixel, true);
+    rank[void_pixel] = r;
+  }
+
+  std::vector<double> mask(mask_pixels);
+  for (int i = 0; i < mask_pixels; ++i) {
+    mask[i] = (rank[i] + 0.5) / mask_pixels;
+  }
+  return mask;
+}
+
+const std::vector<double>& blue_noise_mask() {
+  static const std::vector<double> mask = make_blue_noise_mask();
+  return mask;
+}
+
+// All pixels share one point set, so the scramble seed ignores the pixel.
+uint32_t sequence_seed(uint32_t seed) {
+  return hash_combine(0x2545f491u, seed);
+}
+
+}  // namespace
+
+BlueNoiseSampler::BlueNoiseSampler(int spp, uint32_t seed)
+    : Sampler{spp, seed} {
+  // Build the mask up front rather than on a render thread's first sample.
+  blue_noise_mask();
+}
+
+double BlueNoiseSampler::mask_offset(uint32_t dim) const {
+  const uint32_t shift = hash_u32(dim);
+  const int x = (pixel_col + (shift & 0xff)) % mask_size;
+  const int y = (pixel_row + ((shift >> 8) & 0xff)) % mask_size;
+  return blue_noise_mask()[y * mask_size + x];
+}
+
+double BlueNoiseSampler::get_1d() {
+  const uint32_t dimension_seed = hash_combine(sequence_seed(seed), dimension);
+  const double u =
+      owen_sobol_2d(sample_index, dimension_seed).u + mask_offset(dimension);
+  ++dimension;
+  return u - floor(u);
+}
+
+Point2 BlueNoiseSampler::get_2d() {
+  const uint32_t dimension_seed = hash_combine(sequence_seed(seed), dimension);
+  const Point2 p = owen_sobol_2d(sample_index, dimension_seed);
+  const double u = p.u + mask_offset(dimension);
+  const double v = p.v + mask_offset(dimension + 1);
+  dimension += 2;
+  return Point2{u - floor(u), v - floor(v)};
+}
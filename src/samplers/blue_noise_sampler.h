@@ -0,0 +1,20 @@
+#pragma once
+
+#include "sampler.h"
+
+// Every pixel uses the same Owen-scrambled Sobol points, shifted per pixel by
+// a blue noise mask (Cranley-Patterson rotation). Neighbouring pixels get
+// very different offsets, so the remaining error is spread as high frequency
+// noise, which looks cleaner at low sample counts.
+class BlueNoiseSampler : public Sampler {
+ public:
+  BlueNoiseSampler(int samples_per_pixel, uint32_t seed);
+
+  double get_1d() override;
+  Point2 get_2d() override;
+
+ private:
+  // Mask value in [0, 1) for this pixel, decorrelated across dimensions by a
+  // toroidal shift of the mask.
+  double mask_offset(uint32_t dim) const;
+};
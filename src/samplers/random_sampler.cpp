@@ -0,0 +1,15 @@
+#include "random_sampler.h"
+
+RandomSampler::RandomSampler(int spp, uint32_t seed)
+    : Sampler{spp, seed} {}
+
+double RandomSampler::get_1d() {
+  const uint32_t seed = hash_combine(pixel_seed, sample_index);
+  return to_unit_double(hash_combine(seed, dimension++));
+}
+
+Point2 RandomSampler::get_2d() {
+  const double u = get_1d();
+  const double v = get_1d();
+  return Point2{u, v};
+}
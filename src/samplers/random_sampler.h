@@ -0,0 +1,13 @@
+#pragma once
+
+#include "sampler.h"
+
+// Independent uniform values. Converges at the plain Monte Carlo rate and is
+// the baseline the other samplers are measured against.
+class RandomSampler : public Sampler {
+ public:
+  RandomSampler(int samples_per_pixel, uint32_t seed);
+
+  double get_1d() override;
+  Point2 get_2d() override;
+};
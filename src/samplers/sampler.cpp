@@ -0,0 +1,74 @@
+#include "sampler.h"
+#include <stdexcept>
+#include "blue_noise_sampler.h"
+#include "random_sampler.h"
+#include "sobol_sampler.h"
+#include "stratified_sampler.h"
+
+Sampler::Sampler(int spp, uint32_t s)
+    : samples_per_pixel{spp},
+      seed{s},
+      pixel_col{0},
+      pixel_row{0},
+      pixel_seed{0},
+      sample_index{0},
+      dimension{0} {}
+
+void Sampler::start_sample(int col, int row, int index) {
+  pixel_col = col;
+  pixel_row = row;
+  pixel_seed = hash_combine(hash_combine(hash_u32(col), row), seed);
+  sample_index = index;
+  dimension = 0;
+}
+
+SamplerType parse_sampler_type(const std::string& name) {
+  if (name == "random") {
+    return SamplerType::random;
+  } else if (name == "stratified") {
+    return SamplerType::stratified;
+  } else if (name == "sobol") {
+    return SamplerType::sobol;
+  } else if (name == "blue_noise") {
+    return SamplerType::blue_noise;
+  }
+  throw std::invalid_argument("Unknown sampler: " + name);
+}
+
+std::unique_ptr<Sampler> make_sampler(SamplerType type,
+                                      int samples_per_pixel,
+                                      uint32_t seed) {
+  switch (type) {
+    case SamplerType::random:
+      return std::unique_ptr<Sampler>(
+          new RandomSampler(samples_per_pixel, seed));
+    case SamplerType::stratified:
+      return std::unique_ptr<Sampler>(
+          new StratifiedSampler(samples_per_pixel, seed));
+    case SamplerType::sobol:
+      return std::unique_ptr<Sampler>(
+          new SobolSampler(samples_per_pixel, seed));
+    case SamplerType::blue_noise:
+      return std::unique_ptr<Sampler>(
+          new BlueNoiseSampler(samples_per_pixel, seed));
+  }
+  throw std::invalid_argument("Unknown sampler type");
+}
+
+uint32_t hash_u32(uint32_t x) {
+  // Finalizer from MurmurHash3.
+  x ^= x >> 16;
+  x *= 0x85ebca6bu;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35u;
+  x ^= x >> 16;
+  return x;
+}
+
+uint32_t hash_combine(uint32_t seed, uint32_t v) {
+  return hash_u32(seed ^ (v + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+double to_unit_double(uint32_t x) {
+  return x * (1.0 / 4294967296.0);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+struct Point2 {
+  double u;
+  double v;
+};
+
+// Supplies the random numbers for one pixel sample: the pixel jitter, the
+// lens position and then the dimensions used by every bounce, in the order
+// they are requested. Samplers hold per-sample state, so each render thread
+// needs its own.
+class Sampler {
+ public:
+  // Samplers with different seeds give independent sequences.
+  Sampler(int samples_per_pixel, uint32_t seed);
+  virtual ~Sampler(){};
+
+  // Begins sample `index` of the pixel at (col, row). Dimensions restart at
+  // zero.
+  void start_sample(int col, int row, int index);
+
+  // Values are in [0, 1).
+  virtual double get_1d() = 0;
+  virtual Point2 get_2d() = 0;
+
+ protected:
+  int samples_per_pixel;
+  uint32_t seed;
+  int pixel_col;
+  int pixel_row;
+  uint32_t pixel_seed;
+  uint32_t sample_index;
+  uint32_t dimension;
+};
+
+enum class SamplerType { random, stratified, sobol, blue_noise };
+
+// Throws std::invalid_argument for unknown names.
+SamplerType parse_sampler_type(const std::string& name);
+std::unique_ptr<Sampler> make_sampler(SamplerType type,
+                                      int samples_per_pixel,
+                                      uint32_t seed);
+
+// Hash helpers shared by the samplers.
+uint32_t hash_u32(uint32_t x);
+uint32_t hash_combine(uint32_t seed, uint32_t v);
+// Maps the bits of x to a double in [0, 1).
+double to_unit_double(uint32_t x);
@@ -0,0 +1,69 @@
+#include "sobol_sampler.h"
+
+namespace {
+
+uint32_t reverse_bits(uint32_t x) {
+  x = (x << 16) | (x >> 16);
+  x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+  x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+  x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+  x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+  return x;
+}
+
+uint32_t laine_karras_permutation(uint32_t x, uint32_t seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+// Owen scramble of a 32 bit fixed point value.
+uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) {
+  return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+}
+
+uint32_t sobol_dimension_0(uint32_t index) {
+  return reverse_bits(index);
+}
+
+uint32_t sobol_dimension_1(uint32_t index) {
+  uint32_t result = 0;
+  uint32_t direction = 1u << 31;
+  for (; index != 0; index >>= 1) {
+    if (index & 1) {
+      result ^= direction;
+    }
+    direction ^= direction >> 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+SobolSampler::SobolSampler(int spp, uint32_t seed)
+    : Sampler{spp, seed} {}
+
+double SobolSampler::get_1d() {
+  const uint32_t seed = hash_combine(pixel_seed, dimension++);
+  const uint32_t index = nested_uniform_scramble(sample_index, seed);
+  return to_unit_double(
+      nested_uniform_scramble(sobol_dimension_0(index), hash_u32(seed)));
+}
+
+Point2 SobolSampler::get_2d() {
+  const uint32_t seed = hash_combine(pixel_seed, dimension);
+  dimension += 2;
+  return owen_sobol_2d(sample_index, seed);
+}
+
+Point2 owen_sobol_2d(uint32_t index, uint32_t seed) {
+  const uint32_t shuffled = nested_uniform_scramble(index, seed);
+  const uint32_t x = nested_uniform_scramble(sobol_dimension_0(shuffled),
+                                             hash_combine(seed, 0));
+  const uint32_t y = nested_uniform_scramble(sobol_dimension_1(shuffled),
+                                             hash_combine(seed, 1));
+  return Point2{to_unit_double(x), to_unit_double(y)};
+}
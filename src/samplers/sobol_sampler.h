@@ -0,0 +1,19 @@
+#pragma once
+
+#include "sampler.h"
+
+// Owen-scrambled Sobol points. Each pair of dimensions uses the first two
+// Sobol dimensions with its own scramble and its own shuffle of the sample
+// order, which keeps pairs decorrelated (Burley 2020). Sample counts that are
+// powers of two give the best stratification.
+class SobolSampler : public Sampler {
+ public:
+  SobolSampler(int samples_per_pixel, uint32_t seed);
+
+  double get_1d() override;
+  Point2 get_2d() override;
+};
+
+// Point `index` of the shuffled and Owen-scrambled 2D Sobol sequence selected
+// by seed.
+Point2 owen_sobol_2d(uint32_t index, uint32_t seed);
@@ -0,0 +1,69 @@
+#include "stratified_sampler.h"
+#include <cmath>
+
+namespace {
+
+// Pseudo-random permutation of [0, l) selected by p (Kensler 2013).
+uint32_t permute(uint32_t i, uint32_t l, uint32_t p) {
+  uint32_t w = l - 1;
+  w |= w >> 1;
+  w |= w >> 2;
+  w |= w >> 4;
+  w |= w >> 8;
+  w |= w >> 16;
+  do {
+    i ^= p;
+    i *= 0xe170893du;
+    i ^= p >> 16;
+    i ^= (i & w) >> 4;
+    i ^= p >> 8;
+    i *= 0x0929eb3fu;
+    i ^= p >> 23;
+    i ^= (i & w) >> 1;
+    i *= 1 | p >> 27;
+    i *= 0x6935fa69u;
+    i ^= (i & w) >> 11;
+    i *= 0x74dcb303u;
+    i ^= (i & w) >> 2;
+    i *= 0x9e501cc3u;
+    i ^= (i & w) >> 2;
+    i *= 0xc860a3dfu;
+    i &= w;
+    i ^= i >> 5;
+  } while (i >= l);
+  return (i + p) % l;
+}
+
+double jitter(uint32_t i, uint32_t p) {
+  return to_unit_double(hash_combine(p, i));
+}
+
+}  // namespace
+
+StratifiedSampler::StratifiedSampler(int spp, uint32_t seed)
+    : Sampler{spp, seed} {
+  grid_width = static_cast<int>(ceil(sqrt(static_cast<double>(spp))));
+  grid_height = (spp + grid_width - 1) / grid_width;
+}
+
+double StratifiedSampler::get_1d() {
+  const uint32_t seed = hash_combine(pixel_seed, dimension++);
+  const uint32_t stratum = permute(sample_index, samples_per_pixel, seed);
+  return (stratum + jitter(sample_index, seed * 0x68bc21ebu)) /
+         samples_per_pixel;
+}
+
+Point2 StratifiedSampler::get_2d() {
+  const uint32_t seed = hash_combine(pixel_seed, dimension);
+  dimension += 2;
+
+  const uint32_t m = grid_width;
+  const uint32_t n = grid_height;
+  const uint32_t s = permute(sample_index, m * n, seed * 0x51633e2du);
+  const uint32_t sx = permute(s % m, m, seed * 0xa511e9b3u);
+  const uint32_t sy = permute(s / m, n, seed * 0x63d83595u);
+  const double jx = jitter(s, seed * 0xa399d265u);
+  const double jy = jitter(s, seed * 0x711ad6a5u);
+
+  return Point2{(s % m + (sy + jx) / n) / m, (s / m + (sx + jy) / m) / n};
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "sampler.h"
+
+// Jittered stratification of every dimension. 2D dimensions use correlated
+// multi-jittered sampling (Kensler 2013), which stays stratified in both
+// projections for any sample count.
+class StratifiedSampler : public Sampler {
+ public:
+  StratifiedSampler(int samples_per_pixel, uint32_t seed);
+
+  double get_1d() override;
+  Point2 get_2d() override;
+
+ private:
+  int grid_width;
+  int grid_height;
+};
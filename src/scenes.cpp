@@ -0,0 +1,292 @@
+#include "scenes.h"
+#include <memory>
+#include <stdexcept>
+#include "helpers.h"
+#include "hittables/instance.h"
+#include "hittables/sphere.h"
+#include "hittables/wide_bvh.h"
+#include "materials/dielectric.h"
+#include "materials/emissive.h"
+#include "materials/lambertian.h"
+#include "materials/metal.h"
+#include "textures/image_texture.h"
+#include "transform.h"
+
+namespace {
+
+// Places a copy of the shared unit sphere at center with the given radius.
+std::shared_ptr<Hittable> sphere_instance(
+    const std::shared_ptr<Hittable>& unit_sphere,
+    const Point3& center,
+    double radius,
+    std::shared_ptr<Material> material) {
+  return std::make_shared<Instance>(
+      unit_sphere, Transform::translate(center) * Transform::scale(radius),
+      material);
+}
+
+}  // namespace
+
+HittableList random_scene() {
+  HittableList world;
+  auto unit_sphere = std::make_shared<Sphere>(Point3(0, 0, 0), 1.0, nullptr);
+
+  auto ground_material = std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5));
+  world.add(
+      std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, ground_material));
+
+  const int sqrt_num_spheres = 5;
+  for (int a = 0; a < sqrt_num_spheres; a++) {
+    for (int b = 0; b < sqrt_num_spheres; b++) {
+      int x = map(a, 0, sqrt_num_spheres, -6, 6);
+      int y = map(b, 0, sqrt_num_spheres, -6, 6);
+
+      auto choose_mat = random_double();
+      Point3 center(x + 0.9 * random_double(), 0.2, y + 0.9 * random_double());
+
+      if ((center - Point3(4, 0.2, 0)).length() > 0.9) {
+        std::shared_ptr<Material> sphere_material;
+
+        if (choose_mat < 0.8) {
+          // diffuse
+          auto albedo = random_vec3() * random_vec3();
+          sphere_material = std::make_shared<Lambertian>(albedo);
+          world.add(sphere_instance(unit_sphere, center, 0.2, sphere_material));
+        } else if (choose_mat < 0.95) {
+          // metal
+          auto albedo = random_vec3(0.5, 1);
+          auto fuzz = random_double(0, 0.5);
+          sphere_material = std::make_shared<Metal>(albedo, fuzz);
+          world.add(sphere_instance(unit_sphere, center, 0.2, sphere_material));
+        } else {
+          // glass
+          sphere_material = std::make_shared<Dielectric>(1.5);
+          world.add(sphere_instance(unit_sphere, center, 0.2, sphere_material));
+        }
+      }
+    }
+  }
+
+  auto material1 = std::make_shared<Dielectric>(1.5);
+  world.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0, material1));
+
+  auto material2 = std::make_shared<Lambertian>(Color(0.4, 0.2, 0.1));
+  world.add(std::make_shared<Sphere>(Point3(-4, 1, 0), 1.0, material2));
+
+  auto material3 = std::make_shared<Metal>(Color(0.7, 0.6, 0.5), 0.0);
+  world.add(std::make_shared<Sphere>(Point3(4, 1, 0), 1.0, material3));
+
+  return world;
+}
+
+HittableList scene_1() {
+  HittableList world;
+  auto unit_sphere = std::make_shared<Sphere>(Point3(0, 0, 0), 1.0, nullptr);
+
+  auto ground_material =
+      std::make_shared<Lambertian>(Color(0.3373, 0.4902, 0.2745));
+  world.add(
+      std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, ground_material));
+
+  auto material2 = std::make_shared<Metal>(
+      Color(0.6588235294, 0.662745098, 0.6784313725), 0.5);
+  world.add(std::make_shared<Sphere>(Point3(0, 0.9, 1), 0.9, material2));
+
+  auto material3 =
+      std::make_shared<Lambertian>(Color(1, 0.3254901961, 0.462745098));
+  world.add(std::make_shared<Sphere>(Point3(1.7, 0.7, 2), 0.7, material3));
+
+  auto material4 = std::make_shared<Metal>(Color(1, 0, 0), 0);
+  world.add(std::make_shared<Sphere>(Point3(0, 0.3, 3), 0.3, material4));
+
+  auto material5 = std::make_shared<Dielectric>(1.5);
+  world.add(std::make_shared<Sphere>(Point3(-1, 0.4, 4.8), 0.4, material5));
+
+  auto material6 = std::make_shared<Lambertian>(Color(0, 0, 1));
+  world.add(std::make_shared<Sphere>(Point3(-1.2, 0.13, 3.8), 0.13, material6));
+
+  auto material7 = std::make_shared<Lambertian>(Color(0, 1, 1));
+  world.add(std::make_shared<Sphere>(Point3(-1.5, 0.1, 3.5), 0.1, material7));
+
+  auto material8 = std::make_shared<Metal>(
+      Color(0.6588235294, 0.662745098, 0.6784313725), 0.0);
+  world.add(std::make_shared<Sphere>(Point3(-2.2, 1.5, -1), 1.5, material8));
+
+  for (double x = -8.5; x < -1; x += 0.6) {
+    for (double z = -1.5; z < 5.5; z += 0.6) {
+      double x_offset = random_double(-0.3, 0.3);
+      double z_offset = random_double(-0.3, 0.3);
+      double x_pos = x + x_offset;
+      double z_pos = z + z_offset;
+      if ((x_pos + 2.2) * (x_pos + 2.2) + (z_pos + 1) * (z_pos + 1) < 0.6) {
+        continue;
+      }
+
+      double size = random_double(0.08, 0.14);
+      double material_choice = random_double();
+      if (material_choice < 0.5) {
+        auto material =
+            std::make_shared<Lambertian>(random_vec3() * random_vec3());
+        world.add(sphere_instance(unit_sphere, Point3(x_pos, size, z_pos), size,
+                                  material));
+      } else if (material_choice < 0.8) {
+        double fuzz = random_double();
+        auto material =
+            std::make_shared<Metal>(random_vec3() * random_vec3(), fuzz);
+        world.add(sphere_instance(unit_sphere, Point3(x_pos, size, z_pos), size,
+                                  material));
+
+      } else {
+        auto material = std::make_shared<Dielectric>(random_double());
+        world.add(sphere_instance(unit_sphere, Point3(x_pos, size, z_pos), size,
+                                  material));
+      }
+    }
+  }
+
+  for (double x = -0.3; x < 3.0; x += 0.5) {
+    for (double z = 4.0; z < 7.0; z += 0.5) {
+      double x_offset = random_double(-0.2, 0.2);
+      double z_offset = random_double(-0.2, 0.2);
+
+      double size = random_double(0.08, 0.18);
+      double material_choice = random_double();
+      if (material_choice < 0.5) {
+        auto material =
+            std::make_shared<Lambertian>(random_vec3() * random_vec3());
+        world.add(sphere_instance(
+            unit_sphere, Point3(x + x_offset, size, z + z_offset), size,
+            material));
+      } else if (material_choice < 0.8) {
+        double fuzz = random_double();
+        auto material =
+            std::make_shared<Metal>(random_vec3() * random_vec3(), fuzz);
+        world.add(sphere_instance(
+            unit_sphere, Point3(x + x_offset, size, z + z_offset), size,
+            material));
+
+      } else {
+        auto material = std::make_shared<Dielectric>(random_double());
+        world.add(sphere_instance(
+            unit_sphere, Point3(x + x_offset, size, z + z_offset), size,
+            material));
+      }
+    }
+  }
+
+  return world;
+}
+
+HittableList textured_scene(const std::string& texture_path) {
+  HittableList world;
+  auto unit_sphere = std::make_shared<Sphere>(Point3(0, 0, 0), 1.0, nullptr);
+  auto texture =
+      std::make_shared<ImageTexture>(texture_path, default_texture_cache());
+
+  auto ground_material = std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5));
+  world.add(
+      std::make_shared<Sphere>(Point3(0, -1000, 0), 1000, ground_material));
+
+  world.add(sphere_instance(unit_sphere, Point3(0, 1, 0), 1.0,
+                            std::make_shared<Lambertian>(texture)));
+  world.add(sphere_instance(unit_sphere, Point3(4, 1, 0), 1.0,
+                            std::make_shared<Metal>(texture, 0.2)));
+
+  for (int a = -6; a < 6; ++a) {
+    for (int b = -6; b < 6; ++b) {
+      const Point3 center(a + 0.9 * random_double(), 0.2,
+                          b + 0.9 * random_double());
+      if ((center - Point3(0, 0.2, 0)).length() < 1.2 ||
+          (center - Point3(4, 0.2, 0)).length() < 1.2) {
+        continue;
+      }
+      world.add(sphere_instance(unit_sphere, center, 0.2,
+                                std::make_shared<Lambertian>(texture)));
+    }
+  }
+
+  return world;
+}
+
+HittableList lights_scene() {
+  HittableList world;
+  auto unit_sphere = std::make_shared<Sphere>(Point3(0, 0, 0), 1.0, nullptr);
+
+  world.add(std::make_shared<Sphere>(
+      Point3(0, -1000, 0), 1000,
+      std::make_shared<Lambertian>(Color(0.5, 0.5, 0.5))));
+  // A black dome around everything shuts out the sky, so all the light comes
+  // from the emitting spheres.
+  world.add(std::make_shared<Sphere>(
+      Point3(0, 0, 0), 60, std::make_shared<Emissive>(Color(0, 0, 0))));
+
+  world.add(std::make_shared<Sphere>(
+      Point3(-4, 1, 0), 1.0,
+      std::make_shared<Lambertian>(Color(0.4, 0.2, 0.1))));
+  world.add(std::make_shared<Sphere>(Point3(0, 1, 0), 1.0,
+                                     std::make_shared<Dielectric>(1.5)));
+  world.add(std::make_shared<Sphere>(
+      Point3(4, 1, 0), 1.0,
+      std::make_shared<Metal>(Color(0.7, 0.6, 0.5), 0.3)));
+
+  // Thousands of small lights, a few of them much brighter than the rest.
+  for (int i = 0; i < 2000; ++i) {
+    const Point3 center(random_double(-8, 8), random_double(0.1, 3),
+                        random_double(-8, 8));
+    if ((center - Point3(-4, 1, 0)).length() < 1.2 ||
+        (center - Point3(0, 1, 0)).length() < 1.2 ||
+        (center - Point3(4, 1, 0)).length() < 1.2) {
+      continue;
+    }
+    const double intensity = random_double() < 0.05 ? 40 : 4;
+    const Color tint = random_vec3(0.5, 1);
+    world.add(sphere_instance(unit_sphere, center, random_double(0.02, 0.06),
+                              std::make_shared<Emissive>(intensity * tint)));
+  }
+
+  return world;
+}
+
+HittableList make_scene_objects(const std::string& name) {
+  // Scenes are randomized through rand(). Reseed so a scene comes out the
+  // same no matter what was built before it.
+  srand(1);
+
+  if (name == "scene_1") {
+    return scene_1();
+  } else if (name == "random_scene") {
+    return random_scene();
+  } else if (name == "lights") {
+    return lights_scene();
+  } else if (name.compare(0, 9, "textured:") == 0) {
+    return textured_scene(name.substr(9));
+  }
+  throw std::invalid_argument("Unknown scene: " + name);
+}
+
+std::shared_ptr<const Hittable> make_scene(const std::string& name) {
+  // Top level of the acceleration structure. Instances carry their own
+  // bottom level through the geometry they share.
+  return std::make_shared<WideBvh>(make_scene_objects(name));
+}
+
+CameraSetup scene_camera_setup(const std::string& name) {
+  if (name == "scene_1") {
+    return CameraSetup{Point3(0, 1, 9), Point3(-0.8, 0, -8), Vec3(0, 1, 0),
+                       20, 0.0, 10.0};
+  } else if (name == "random_scene") {
+    return CameraSetup{Point3(13, 2, 3), Point3(0, 0, 0), Vec3(0, 1, 0), 20,
+                       0.1, 10.0};
+  } else if (name == "lights") {
+    return CameraSetup{Point3(13, 2, 3), Point3(0, 0, 0), Vec3(0, 1, 0), 30,
+                       0.0, 10.0};
+  } else if (name.compare(0, 9, "textured:") == 0) {
+    return CameraSetup{Point3(10, 3, 6), Point3(2, 0.5, 0), Vec3(0, 1, 0), 30,
+                       0.0, 10.0};
+  }
+  throw std::invalid_argument("Unknown scene: " + name);
+}
+
+Camera make_scene_camera(const std::string& name, double aspect_ratio) {
+  return scene_camera_setup(name).to_camera(aspect_ratio);
+}
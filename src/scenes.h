@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "camera.h"
+#include "hittables/hittable_list.h"
+
+HittableList scene_1();
+HittableList random_scene();
+// Lit only by two thousand small emitting spheres.
+HittableList lights_scene();
+// Spheres wearing the image of a tiled texture file.
+HittableList textured_scene(const std::string& texture_path);
+
+// Top-level objects of the named scene ("scene_1", "random_scene", "lights"
+// or "textured:<texture file>"). Throws std::invalid_argument for unknown
+// names.
+HittableList make_scene_objects(const std::string& name);
+// Builds the named scene with its acceleration structure. Throws
+// std::invalid_argument for unknown names.
+std::shared_ptr<const Hittable> make_scene(const std::string& name);
+// The camera placement each scene was composed for.
+CameraSetup scene_camera_setup(const std::string& name);
+Camera make_scene_camera(const std::string& name, double aspect_ratio);
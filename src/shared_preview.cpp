@@ -0,0 +1,150 @@
+#include "shared_preview.h"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Preview atomics must be lock-free to work across processes");
+static_assert(sizeof(Color) == 3 * sizeof(double),
+              "Preview pixels are three doubles");
+
+namespace {
+
+uint64_t double_bits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double bits_double(uint64_t bits) {
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+size_t align_up(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+PreviewStatus read_preview_status(const PreviewHeader& header) {
+  const std::memory_order relaxed = std::memory_order_relaxed;
+  PreviewStatus status;
+  uint32_t before;
+  uint32_t after;
+  do {
+    before = header.sequence.load(std::memory_order_acquire);
+    status.rendering = header.rendering.load(relaxed) != 0;
+    status.samples_per_pixel = header.samples_per_pixel.load(relaxed);
+    status.pass_first_sample = header.pass_first_sample.load(relaxed);
+    status.pass_sample_count = header.pass_sample_count.load(relaxed);
+    status.pixels = header.pixels.load(relaxed);
+    status.rays = header.rays.load(relaxed);
+    status.seconds = bits_double(header.seconds.load(relaxed));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = header.sequence.load(relaxed);
+  } while ((before & 1) != 0 || before != after);
+  return status;
+}
+
+SharedPreview::SharedPreview(const std::string& n,
+                             int width,
+                             int height,
+                             int tile_size)
+    : name{"/" + n},
+      size{0},
+      header{nullptr},
+      tile_samples{nullptr},
+      pixels{nullptr} {
+  const int tiles_x = (width + tile_size - 1) / tile_size;
+  const int tiles_y = (height + tile_size - 1) / tile_size;
+  const size_t tiles_offset = align_up(sizeof(PreviewHeader), 64);
+  const size_t pixels_offset =
+      align_up(tiles_offset + tiles_x * tiles_y * sizeof(uint32_t), 64);
+  size = pixels_offset + static_cast<size_t>(width) * height * sizeof(Color);
+
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot create shared memory " + name);
+  }
+  void* memory = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (memory == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("Cannot map shared memory " + name);
+  }
+
+  // The segment starts zeroed, which is a valid state for every field.
+  char* base = static_cast<char*>(memory);
+  header = new (base) PreviewHeader;
+  tile_samples = reinterpret_cast<std::atomic<uint32_t>*>(base + tiles_offset);
+  pixels = reinterpret_cast<Color*>(base + pixels_offset);
+  for (int i = 0; i < width * height; ++i) {
+    new (&pixels[i]) Color{0, 0, 0};
+  }
+
+  std::memcpy(header->magic, "rtprev1", 8);
+  header->width = width;
+  header->height = height;
+  header->tile_size = tile_size;
+  header->tiles_x = tiles_x;
+  header->tiles_y = tiles_y;
+  header->tile_samples_offset = tiles_offset;
+  header->pixels_offset = pixels_offset;
+}
+
+SharedPreview::~SharedPreview() {
+  munmap(header, size);
+  shm_unlink(name.c_str());
+}
+
+int SharedPreview::get_width() const {
+  return header->width;
+}
+
+int SharedPreview::get_height() const {
+  return header->height;
+}
+
+int SharedPreview::get_tile_size() const {
+  return header->tile_size;
+}
+
+Color* SharedPreview::get_pixels() {
+  return pixels;
+}
+
+void SharedPreview::set_tile_samples(int tile_row, int tile_col, int samples) {
+  // Release, so a reader that sees the count also sees the tile's pixels.
+  tile_samples[tile_row * header->tiles_x + tile_col].store(
+      samples, std::memory_order_release);
+}
+
+void SharedPreview::set_all_tile_samples(int samples) {
+  for (uint32_t i = 0; i < header->tiles_x * header->tiles_y; ++i) {
+    tile_samples[i].store(samples, std::memory_order_release);
+  }
+}
+
+void SharedPreview::publish(const PreviewStatus& status) {
+  const std::memory_order relaxed = std::memory_order_relaxed;
+  const uint32_t sequence = header->sequence.load(relaxed);
+  header->sequence.store(sequence + 1, relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->rendering.store(status.rendering, relaxed);
+  header->samples_per_pixel.store(status.samples_per_pixel, relaxed);
+  header->pass_first_sample.store(status.pass_first_sample, relaxed);
+  header->pass_sample_count.store(status.pass_sample_count, relaxed);
+  header->pixels.store(status.pixels, relaxed);
+  header->rays.store(status.rays, relaxed);
+  header->seconds.store(double_bits(status.seconds), relaxed);
+  header->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "vec3.h"
+
+// What a renderer is doing, as published to a preview.
+struct PreviewStatus {
+  // False once the pass has finished.
+  bool rendering;
+  int samples_per_pixel;
+  // The pass adds samples [pass_first_sample, + pass_sample_count).
+  int pass_first_sample;
+  int pass_sample_count;
+  long long pixels;
+  long long rays;
+  double seconds;
+};
+
+// Start of a preview segment. The tile sample counts and the framebuffer
+// follow at the given byte offsets. The framebuffer holds width * height
+// pixels of three doubles, the sums of their samples, row major with row 0
+// at the bottom. The count of a tile is the number of samples all of its
+// pixels hold; pixels of a tile that is rendering may hold more.
+struct PreviewHeader {
+  // "rtprev1", and a terminating 0.
+  char magic[8];
+  uint32_t width;
+  uint32_t height;
+  uint32_t tile_size;
+  uint32_t tiles_x;
+  uint32_t tiles_y;
+  uint64_t tile_samples_offset;
+  uint64_t pixels_offset;
+
+  // Seqlock over the status fields below: odd while they are being written.
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint64_t> rendering;
+  std::atomic<uint64_t> samples_per_pixel;
+  std::atomic<uint64_t> pass_first_sample;
+  std::atomic<uint64_t> pass_sample_count;
+  std::atomic<uint64_t> pixels;
+  std::atomic<uint64_t> rays;
+  // Bits of a double.
+  std::atomic<uint64_t> seconds;
+};
+
+// Copies a consistent status out of a mapped header, retrying while the
+// renderer writes it. Never blocks the renderer.
+PreviewStatus read_preview_status(const PreviewHeader& header);
+
+// Framebuffer of a render in a POSIX shared memory segment, so that other
+// processes can map it read-only and watch the image converge. The renderer
+// accumulates into the segment directly and updates tile counts with single
+// atomic stores, so render threads neither copy nor lock anything for it.
+// The segment is removed when the preview is destroyed.
+class SharedPreview {
+ public:
+  // Creates the segment /name, replacing any old one. Throws
+  // std::runtime_error if it cannot be created.
+  SharedPreview(const std::string& name,
+                int width,
+                int height,
+                int tile_size);
+  ~SharedPreview();
+  SharedPreview(const SharedPreview&) = delete;
+  SharedPreview& operator=(const SharedPreview&) = delete;
+
+  int get_width() const;
+  int get_height() const;
+  int get_tile_size() const;
+  Color* get_pixels();
+
+  void set_tile_samples(int tile_row, int tile_col, int samples);
+  void set_all_tile_samples(int samples);
+  // Only one thread may publish at a time.
+  void publish(const PreviewStatus& status);
+
+ private:
+  std::string name;
+  size_t size;
+  PreviewHeader* header;
+  std::atomic<uint32_t>* tile_samples;
+  Color* pixels;
+};
@@ -0,0 +1,47 @@
+#include "image_texture.h"
+#include <algorithm>
+#include <cmath>
+
+ImageTexture::ImageTexture(const std::string& path, TextureCache& c)
+    : file{std::make_shared<TextureFile>(path)}, cache(c) {}
+
+Color ImageTexture::value(double u, double v, double footprint) const {
+  // The level whose texels are about as wide as the footprint.
+  const int top = file->get_level_count() - 1;
+  const double texels =
+      footprint * std::max(file->get_width(0), file->get_height(0));
+  const int level =
+      texels > 1 ? std::min(static_cast<int>(std::log2(texels)), top) : 0;
+
+  const int width = file->get_width(level);
+  const int height = file->get_height(level);
+  const int tile_size = file->get_tile_size();
+  const double x = (u - std::floor(u)) * width - 0.5;
+  const double y = std::min(std::max(v, 0.0), 1.0) * height - 0.5;
+  const int x0 = static_cast<int>(std::floor(x));
+  const int y0 = static_cast<int>(std::floor(y));
+  const double fx = x - x0;
+  const double fy = y - y0;
+
+  // The four texels usually share a tile, which is then fetched once.
+  std::shared_ptr<const std::vector<float>> tile;
+  int tile_x = -1;
+  int tile_y = -1;
+  Color sum{0, 0, 0};
+  for (int i = 0; i < 4; ++i) {
+    const int col = ((x0 + (i & 1)) % width + width) % width;
+    const int row = std::min(std::max(y0 + (i >> 1), 0), height - 1);
+    if (col / tile_size != tile_x || row / tile_size != tile_y) {
+      tile_x = col / tile_size;
+      tile_y = row / tile_size;
+      tile = cache.get_tile(*file, level, tile_x, tile_y);
+    }
+    const float* texel =
+        tile->data() +
+        3 * ((row % tile_size) * tile_size + col % tile_size);
+    const double weight =
+        ((i & 1) ? fx : 1 - fx) * ((i >> 1) ? fy : 1 - fy);
+    sum += weight * Color{texel[0], texel[1], texel[2]};
+  }
+  return sum;
+}
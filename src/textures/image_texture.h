@@ -0,0 +1,22 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "texture.h"
+#include "texture_cache.h"
+
+// Texture read from a tiled texture file through a TextureCache, so that only
+// the tiles rays touch are in memory. The mip level is picked from the
+// footprint of the lookup, and texels are filtered bilinearly within it. The
+// image wraps around in u and is clamped in v.
+class ImageTexture : public Texture {
+ public:
+  // Throws std::runtime_error if the file cannot be opened.
+  ImageTexture(const std::string& path, TextureCache& cache);
+
+  Color value(double u, double v, double footprint) const override;
+
+ private:
+  std::shared_ptr<TextureFile> file;
+  TextureCache& cache;
+};
@@ -0,0 +1,7 @@
+#include "solid_color.h"
+
+SolidColor::SolidColor(const Color& c) : color{c} {}
+
+Color SolidColor::value(double, double, double) const {
+  return color;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "texture.h"
+
+class SolidColor : public Texture {
+ public:
+  SolidColor(const Color& c);
+
+  Color value(double u, double v, double footprint) const override;
+
+ private:
+  Color color;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "../vec3.h"
+
+class Texture {
+ public:
+  Texture(){};
+  // Color at texture coordinates (u, v), averaged over a footprint that wide
+  // in texture coordinates.
+  virtual Color value(double u, double v, double footprint) const = 0;
+  virtual ~Texture(){};
+};
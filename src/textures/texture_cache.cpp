@@ -0,0 +1,256 @@
+#include "texture_cache.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../helpers.h"
+#include "../image_io.h"
+
+namespace {
+
+// "RTTX" in little-endian order.
+const uint32_t texture_magic = 0x58545452;
+const size_t header_words = 6;
+
+std::atomic<uint32_t> next_texture_id{1};
+
+size_t tile_bytes(int tile_size) {
+  return static_cast<size_t>(tile_size) * tile_size * 3 * sizeof(float);
+}
+
+// Halves an image, averaging each 2x2 block. An odd last row or column is
+// averaged with itself.
+std::vector<Color> downsample(const std::vector<Color>& image,
+                              int width,
+                              int height,
+                              int& new_width,
+                              int& new_height) {
+  new_width = std::max(width / 2, 1);
+  new_height = std::max(height / 2, 1);
+  std::vector<Color> out(new_width * new_height);
+  for (int y = 0; y < new_height; ++y) {
+    for (int x = 0; x < new_width; ++x) {
+      const int x0 = std::min(2 * x, width - 1);
+      const int x1 = std::min(2 * x + 1, width - 1);
+      const int y0 = std::min(2 * y, height - 1);
+      const int y1 = std::min(2 * y + 1, height - 1);
+      out[y * new_width + x] =
+          (image[y0 * width + x0] + image[y0 * width + x1] +
+           image[y1 * width + x0] + image[y1 * width + x1]) /
+          4;
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+void make_tiled_texture(const std::string& pfm_path,
+                        const std::string& texture_path,
+                        int tile_size) {
+  int width, height;
+  std::vector<Color> image;
+  if (!read_pfm(pfm_path, width, height, image)) {
+    throw std::runtime_error("Cannot read " + pfm_path);
+  }
+  if (tile_size <= 0) {
+    throw std::invalid_argument("Texture tiles need a positive size");
+  }
+
+  int levels = 1;
+  while ((width >> (levels - 1)) > 1 || (height >> (levels - 1)) > 1) {
+    ++levels;
+  }
+
+  std::ofstream out(texture_path, std::ios::binary);
+  const uint32_t header[header_words] = {
+      texture_magic,
+      static_cast<uint32_t>(width),
+      static_cast<uint32_t>(height),
+      static_cast<uint32_t>(tile_size),
+      static_cast<uint32_t>(levels),
+      0};
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+  std::vector<float> tile(tile_size * tile_size * 3);
+  int level_width = width;
+  int level_height = height;
+  for (int level = 0; level < levels; ++level) {
+    const int tiles_x = (level_width + tile_size - 1) / tile_size;
+    const int tiles_y = (level_height + tile_size - 1) / tile_size;
+    for (int ty = 0; ty < tiles_y; ++ty) {
+      for (int tx = 0; tx < tiles_x; ++tx) {
+        float* texel = tile.data();
+        for (int y = 0; y < tile_size; ++y) {
+          const int row = std::min(ty * tile_size + y, level_height - 1);
+          for (int x = 0; x < tile_size; ++x) {
+            const int col = std::min(tx * tile_size + x, level_width - 1);
+            const Color& c = image[row * level_width + col];
+            *texel++ = c.get_x();
+            *texel++ = c.get_y();
+            *texel++ = c.get_z();
+          }
+        }
+        out.write(reinterpret_cast<const char*>(tile.data()),
+                  tile_bytes(tile_size));
+      }
+    }
+    if (level + 1 < levels) {
+      image = downsample(image, level_width, level_height, level_width,
+                         level_height);
+    }
+  }
+  if (!out) {
+    throw std::runtime_error("Cannot write " + texture_path);
+  }
+}
+
+TextureFile::TextureFile(const std::string& p)
+    : path{p}, fd{open(p.c_str(), O_RDONLY)}, id{next_texture_id++} {
+  uint32_t header[header_words];
+  if (fd < 0 ||
+      pread(fd, header, sizeof(header), 0) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      header[0] != texture_magic || header[1] == 0 || header[2] == 0 ||
+      header[3] == 0 || header[4] == 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw std::runtime_error("Cannot read tiled texture " + path);
+  }
+
+  tile_size = header[3];
+  uint64_t offset = sizeof(header);
+  for (uint32_t level = 0; level < header[4]; ++level) {
+    const int width = std::max<int>(header[1] >> level, 1);
+    const int height = std::max<int>(header[2] >> level, 1);
+    widths.push_back(width);
+    heights.push_back(height);
+    offsets.push_back(offset);
+    const uint64_t tiles = static_cast<uint64_t>(
+                               (width + tile_size - 1) / tile_size) *
+                           ((height + tile_size - 1) / tile_size);
+    offset += tiles * tile_bytes(tile_size);
+  }
+
+  // Check the length here, where the error reaches whoever opened the file,
+  // rather than when a render thread first reads a missing tile.
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<uint64_t>(info.st_size) < offset) {
+    close(fd);
+    throw std::runtime_error("Tiled texture " + path + " is truncated");
+  }
+}
+
+TextureFile::~TextureFile() {
+  close(fd);
+}
+
+uint32_t TextureFile::get_id() const {
+  return id;
+}
+
+int TextureFile::get_tile_size() const {
+  return tile_size;
+}
+
+int TextureFile::get_level_count() const {
+  return widths.size();
+}
+
+int TextureFile::get_width(int level) const {
+  return widths[level];
+}
+
+int TextureFile::get_height(int level) const {
+  return heights[level];
+}
+
+void TextureFile::read_tile(int level,
+                            int tile_x,
+                            int tile_y,
+                            float* texels) const {
+  const int tiles_x = (widths[level] + tile_size - 1) / tile_size;
+  const size_t bytes = tile_bytes(tile_size);
+  const uint64_t offset =
+      offsets[level] + (static_cast<uint64_t>(tile_y) * tiles_x + tile_x) *
+                           bytes;
+
+  char* buffer = reinterpret_cast<char*>(texels);
+  size_t done = 0;
+  while (done < bytes) {
+    const ssize_t n = pread(fd, buffer + done, bytes - done, offset + done);
+    if (n <= 0) {
+      throw std::runtime_error("Cannot read a tile of " + path);
+    }
+    done += n;
+  }
+}
+
+TextureCache::TextureCache(size_t capacity)
+    : shard_capacity{capacity / shard_count} {}
+
+void TextureCache::set_capacity(size_t capacity) {
+  shard_capacity = capacity / shard_count;
+  for (Shard& shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    trim(shard);
+  }
+}
+
+std::shared_ptr<const std::vector<float>> TextureCache::get_tile(
+    const TextureFile& file,
+    int level,
+    int tile_x,
+    int tile_y) {
+  const uint32_t fields[] = {file.get_id(), static_cast<uint32_t>(level),
+                             static_cast<uint32_t>(tile_x),
+                             static_cast<uint32_t>(tile_y)};
+  const uint64_t key = hash_bytes(fields, sizeof(fields));
+  Shard& shard = shards[(key >> 32) % shard_count];
+
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries,
+                           found->second);
+      return found->second->second;
+    }
+  }
+
+  // Load without holding the lock, so that other threads keep reading the
+  // shard. Two threads missing the same tile both load it, and the first
+  // one's copy is kept.
+  const int tile_size = file.get_tile_size();
+  auto tile = std::make_shared<std::vector<float>>(tile_size * tile_size * 3);
+  file.read_tile(level, tile_x, tile_y, tile->data());
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto found = shard.index.find(key);
+  if (found != shard.index.end()) {
+    return found->second->second;
+  }
+  shard.entries.emplace_front(key, tile);
+  shard.index[key] = shard.entries.begin();
+  shard.bytes += tile->size() * sizeof(float);
+  trim(shard);
+  return tile;
+}
+
+void TextureCache::trim(Shard& shard) {
+  // Keep the newest tile even if it alone is over the budget.
+  while (shard.bytes > shard_capacity && shard.entries.size() > 1) {
+    const Entry& oldest = shard.entries.back();
+    shard.bytes -= oldest.second->size() * sizeof(float);
+    shard.index.erase(oldest.first);
+    shard.entries.pop_back();
+  }
+}
+
+TextureCache& default_texture_cache() {
+  static TextureCache cache(size_t(256) << 20);
+  return cache;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A tiled texture file is a mip chain of square tiles, so that a renderer can
+// read the parts of the levels it needs instead of the whole image. It starts
+// with six little-endian 32-bit words: the magic number, width, height, tile
+// size, level count and a reserved 0. Each level then follows, half the size
+// of the one before, as rows of tiles from the bottom of the image up. A tile
+// is tile_size rows of tile_size RGB 32-bit float texels, bottom row first,
+// padded with copies of the last texel at the image edges.
+
+// Converts a PFM image to a tiled texture file. Throws std::runtime_error if
+// either file cannot be used.
+void make_tiled_texture(const std::string& pfm_path,
+                        const std::string& texture_path,
+                        int tile_size = 64);
+
+// An open tiled texture file.
+class TextureFile {
+ public:
+  // Throws std::runtime_error if the file is missing, malformed or shorter
+  // than its header says.
+  TextureFile(const std::string& path);
+  ~TextureFile();
+  TextureFile(const TextureFile&) = delete;
+  TextureFile& operator=(const TextureFile&) = delete;
+
+  // Unique among the files opened by the process.
+  uint32_t get_id() const;
+  int get_tile_size() const;
+  int get_level_count() const;
+  int get_width(int level) const;
+  int get_height(int level) const;
+
+  // Reads one tile of tile_size * tile_size RGB texels. Safe to call from
+  // many threads at once.
+  void read_tile(int level, int tile_x, int tile_y, float* texels) const;
+
+ private:
+  std::string path;
+  int fd;
+  uint32_t id;
+  int tile_size;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  // Byte offset of each level in the file.
+  std::vector<uint64_t> offsets;
+};
+
+// Tiles of tiled texture files, loaded on first use and shared by all render
+// threads. Holds at most capacity bytes of tiles and evicts the least
+// recently used. The tiles are split into shards by key, each with its own
+// lock and LRU list, so that threads rarely wait for each other.
+class TextureCache {
+ public:
+  TextureCache(size_t capacity);
+
+  void set_capacity(size_t capacity);
+  // Returns the RGB texels of a tile, loading it if needed. The tile stays
+  // valid while the pointer is held, even if it is evicted.
+  std::shared_ptr<const std::vector<float>> get_tile(const TextureFile& file,
+                                                     int level,
+                                                     int tile_x,
+                                                     int tile_y);
+
+ private:
+  typedef std::pair<uint64_t, std::shared_ptr<const std::vector<float>>> Entry;
+
+  struct Shard {
+    std::mutex mutex;
+    // Most recently used first.
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+  };
+
+  static const int shard_count = 16;
+
+  // Evicts from the back until the shard fits in its share of the capacity.
+  void trim(Shard& shard);
+
+  std::atomic<size_t> shard_capacity;
+  Shard shards[shard_count];
+};
+
+// Cache used by the textures of the bundled scenes, 256 MB unless changed.
+TextureCache& default_texture_cache();
@@ -0,0 +1,74 @@
+#include "thread_pool.h"
+#include <stdexcept>
+#include <string>
+
+ThreadPool::ThreadPool(int num_threads) : stopping{false} {
+  if (num_threads < 1) {
+    throw std::invalid_argument("Need at least one thread, not " +
+                                std::to_string(num_threads));
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  job_added.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+int ThreadPool::size() const {
+  return workers.size();
+}
+
+void ThreadPool::run(const std::vector<std::function<void()>>& tasks) {
+  if (tasks.empty()) {
+    return;
+  }
+
+  auto job = std::make_shared<Job>();
+  job->tasks = &tasks;
+  job->next_task = 0;
+  job->remaining = tasks.size();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobs.push_back(job);
+  job_added.notify_all();
+  job->done.wait(lock, [&] { return job->remaining == 0; });
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::shared_ptr<Job> job;
+    size_t task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      job_added.wait(lock, [&] { return stopping || !jobs.empty(); });
+      if (jobs.empty()) {
+        return;
+      }
+
+      // Take one task from the front job, then send it to the back of the
+      // queue if it has more.
+      job = jobs.front();
+      jobs.pop_front();
+      task = job->next_task++;
+      if (job->next_task < job->tasks->size()) {
+        jobs.push_back(job);
+      }
+    }
+
+    (*job->tasks)[task]();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--job->remaining == 0) {
+      job->done.notify_all();
+    }
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads shared by every render. Each call to run() is a
+// job; jobs are served round robin one task at a time, so a large job cannot
+// starve a small one that arrives later.
+class ThreadPool {
+ public:
+  // Throws std::invalid_argument for fewer than one thread, since run()
+  // would wait forever.
+  ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  int size() const;
+
+  // Runs the tasks on the pool and blocks until all of them have finished.
+  // Safe to call from several threads at once.
+  void run(const std::vector<std::function<void()>>& tasks);
+
+ private:
+  struct Job {
+    const std::vector<std::function<void()>>* tasks;
+    size_t next_task;
+    size_t remaining;
+    std::condition_variable done;
+  };
+
+  void work();
+
+  std::vector<std::thread> workers;
+  std::deque<std::shared_ptr<Job>> jobs;
+  bool stopping;
+  std::mutex mutex;
+  std::condition_variable job_added;
+};
@@ -0,0 +1,98 @@
+#include "transform.h"
+#include <cmath>
+#include "helpers.h"
+
+Transform::Transform() {
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      m[i][j] = i == j ? 1.0 : 0.0;
+    }
+  }
+}
+
+Transform Transform::translate(const Vec3& offset) {
+  Transform t;
+  t.m[0][3] = offset.get_x();
+  t.m[1][3] = offset.get_y();
+  t.m[2][3] = offset.get_z();
+  return t;
+}
+
+Transform Transform::scale(double factor) {
+  return scale(Vec3(factor, factor, factor));
+}
+
+Transform Transform::scale(const Vec3& factors) {
+  Transform t;
+  t.m[0][0] = factors.get_x();
+  t.m[1][1] = factors.get_y();
+  t.m[2][2] = factors.get_z();
+  return t;
+}
+
+Transform Transform::rotate_y(double degrees) {
+  const double theta = degrees_to_radians(degrees);
+  Transform t;
+  t.m[0][0] = cos(theta);
+  t.m[0][2] = sin(theta);
+  t.m[2][0] = -sin(theta);
+  t.m[2][2] = cos(theta);
+  return t;
+}
+
+Transform Transform::inverse() const {
+  // Invert the linear part with the adjugate, then move the translation.
+  const double inv_det = 1.0 / determinant();
+
+  Transform t;
+  t.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+  t.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+  t.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+  t.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+  t.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+  t.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+  t.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+  t.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+  t.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+
+  for (int i = 0; i < 3; ++i) {
+    t.m[i][3] =
+        -(t.m[i][0] * m[0][3] + t.m[i][1] * m[1][3] + t.m[i][2] * m[2][3]);
+  }
+  return t;
+}
+
+double Transform::determinant() const {
+  return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+         m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+         m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+Point3 Transform::apply_point(const Point3& p) const {
+  return apply_vector(p) + Vec3(m[0][3], m[1][3], m[2][3]);
+}
+
+Vec3 Transform::apply_vector(const Vec3& v) const {
+  const double x = v.get_x(), y = v.get_y(), z = v.get_z();
+  return Vec3(m[0][0] * x + m[0][1] * y + m[0][2] * z,
+              m[1][0] * x + m[1][1] * y + m[1][2] * z,
+              m[2][0] * x + m[2][1] * y + m[2][2] * z);
+}
+
+Vec3 Transform::apply_transpose(const Vec3& v) const {
+  const double x = v.get_x(), y = v.get_y(), z = v.get_z();
+  return Vec3(m[0][0] * x + m[1][0] * y + m[2][0] * z,
+              m[0][1] * x + m[1][1] * y + m[2][1] * z,
+              m[0][2] * x + m[1][2] * y + m[2][2] * z);
+}
+
+Transform operator*(const Transform& a, const Transform& b) {
+  Transform t;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      t.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] +
+                  a.m[i][2] * b.m[2][j] + (j == 3 ? a.m[i][3] : 0.0);
+    }
+  }
+  return t;
+}
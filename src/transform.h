@@ -0,0 +1,33 @@
+#pragma once
+
+#include "vec3.h"
+
+// Affine transform stored as the top three rows of a 4x4 matrix. The last row
+// is always (0, 0, 0, 1).
+class Transform {
+ public:
+  Transform();
+
+  static Transform translate(const Vec3& offset);
+  static Transform scale(double factor);
+  static Transform scale(const Vec3& factors);
+  static Transform rotate_y(double degrees);
+
+  Transform inverse() const;
+  // Determinant of the linear part, the factor by which volumes grow.
+  double determinant() const;
+
+  Point3 apply_point(const Point3& p) const;
+  Vec3 apply_vector(const Vec3& v) const;
+  // Multiplies by the transpose of the linear part. Given the inverse of a
+  // transform, this maps normals through the original transform.
+  Vec3 apply_transpose(const Vec3& v) const;
+
+  friend Transform operator*(const Transform& a, const Transform& b);
+
+ private:
+  double m[3][4];
+};
+
+// Composes two transforms so that (a * b) applies b first, then a.
+Transform operator*(const Transform& a, const Transform& b);
@@ -173,4 +173,20 @@ Vec3 random_in_unit_disk() {
       continue;
     return p;
   }
-}
\ No newline at end of file
+}
+Vec3 sample_unit_vector(double u, double v) {
+  const double z = 1 - 2 * u;
+  const double r = sqrt(fmax(0.0, 1 - z * z));
+  const double phi = 2 * pi * v;
+  return Vec3(r * cos(phi), r * sin(phi), z);
+}
+
+Vec3 sample_in_unit_sphere(double u, double v, double w) {
+  return cbrt(w) * sample_unit_vector(u, v);
+}
+
+Vec3 sample_in_unit_disk(double u, double v) {
+  const double r = sqrt(u);
+  const double theta = 2 * pi * v;
+  return Vec3(r * cos(theta), r * sin(theta), 0);
+}
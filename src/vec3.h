@@ -49,5 +49,10 @@ Vec3 refract(const Vec3& uv, const Vec3& n, double etai_over_etat);
 
 Vec3 random_in_unit_disk();
 
+// Warps of uniform values in [0, 1) for use with a Sampler.
+Vec3 sample_unit_vector(double u, double v);
+Vec3 sample_in_unit_sphere(double u, double v, double w);
+Vec3 sample_in_unit_disk(double u, double v);
+
 using Point3 = Vec3;
 using Color = Vec3;